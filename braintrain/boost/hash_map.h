@@ -4,6 +4,7 @@
 #include <string>           // For std::string
 #include <unordered_map>    // For std::unordered_map
 #include <vector>           // To hold carriage information (optional, but good for example)
+#include "../common/headers/Symbol.h" // Interned strings for the carriage type
 struct Carriage;
 
 std::ostream& operator<<(std::ostream& os, const Carriage& carriage);
@@ -12,7 +13,7 @@ std::ostream& operator<<(std::ostream& os, const Carriage& carriage);
 struct Carriage {
     std::string id;
     int capacity;
-    std::string type; // e.g., "Passenger", "Cargo", "Restaurant"
+    Symbol type; // e.g., "Passenger", "Cargo", "Restaurant": a handful of values shared by every carriage, so interned
 
     // Constructor for convenience (using const std::string& instead of string_view)
     Carriage(const std::string& id_val, int cap, const std::string& type_val)
@@ -0,0 +1,120 @@
+#ifndef BRAINTRAIN_DISPATCH_H
+#define BRAINTRAIN_DISPATCH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BRAINTRAIN_X86 1
+#endif
+
+// picking simd kernels at run time, shared by every module that has them (einstein reductions and gemm, khwarizmi
+// ComplexArray, newton bytescan, riemann FleetTable and predicates).
+// A module compiles its wide kernels with __attribute__((target(...))) so the rest of the build stays baseline, lists
+// them per level in a Dispatch, and calls thru kernels(). The level used is the widest one that both the module has
+// kernels for and the cpu runs (cpuid thru __builtin_cpu_supports, asked once per process)
+namespace cpu {
+    // ordered narrow to wide, each level includes the ones below. avx2 means avx2 and fma (every chip with one has the
+    // other), avx512 means avx512f
+    enum class Isa {
+        scalar, sse2, avx2, avx512
+    };
+
+    inline constexpr int isa_count = 4;
+
+    // the widest level this cpu runs
+    inline Isa detect() noexcept {
+        static const Isa best = [] {
+#ifdef BRAINTRAIN_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return Isa::avx512;
+            }
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                return Isa::avx2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return Isa::sse2;
+            }
+#endif
+            return Isa::scalar;
+        }();
+        return best;
+    }
+
+    inline bool supports(Isa isa) noexcept {
+        return isa <= detect();
+    }
+
+    inline const char *isa_name(Isa isa) noexcept {
+        switch (isa) {
+            case Isa::scalar:
+                return "scalar";
+            case Isa::sse2:
+                return "sse2";
+            case Isa::avx2:
+                return "avx2";
+            case Isa::avx512:
+                return "avx512";
+        }
+        return "unknown";
+    }
+
+    // one table of kernels (a struct of function pointers) per level; a module does not need all of them, but it needs
+    // scalar. The tables are fixed once constructed and the level in use is an atomic, so use() can be called while other
+    // threads run kernels: a call already running finishes with the table it started with, the next one gets the new one
+    template<typename Kernels>
+    class Dispatch {
+    public:
+        Dispatch(std::initializer_list<std::pair<Isa, Kernels>> levels) {
+            for (const auto &[isa, kernels] : levels) {
+                tables[index(isa)] = kernels;
+                present[index(isa)] = true;
+            }
+            if (!present[0]) {
+                throw std::logic_error("a dispatch needs scalar kernels");
+            }
+            widest = pick(Isa::avx512);
+            current.store(widest, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] const Kernels &kernels() const noexcept {
+            return tables[index(current.load(std::memory_order_relaxed))];
+        }
+
+        [[nodiscard]] Isa active() const noexcept { return current.load(std::memory_order_relaxed); }
+
+        // the widest level in use when nothing is forced
+        [[nodiscard]] Isa supported() const noexcept { return widest; }
+
+        // force a narrower level (for benchmarking): clamped down to the widest one that exists and the cpu runs.
+        // returns the level in use afterwards
+        Isa use(Isa wanted) noexcept {
+            Isa isa = pick(wanted);
+            current.store(isa, std::memory_order_relaxed);
+            return isa;
+        }
+
+    private:
+        std::array<Kernels, isa_count> tables {};
+        std::array<bool, isa_count> present {};
+        Isa widest = Isa::scalar;
+        std::atomic<Isa> current {Isa::scalar};
+
+        static int index(Isa isa) noexcept { return static_cast<int>(isa); }
+
+        [[nodiscard]] Isa pick(Isa wanted) const noexcept {
+            int i = std::min(index(wanted), index(detect()));
+            while (!present[i]) {
+                --i;
+            }
+            return static_cast<Isa>(i);
+        }
+    };
+}
+
+#endif //BRAINTRAIN_DISPATCH_H
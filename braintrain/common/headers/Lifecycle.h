@@ -0,0 +1,227 @@
+#ifndef BRAINTRAIN_LIFECYCLE_H
+#define BRAINTRAIN_LIFECYCLE_H
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+// lifecycle telemetry for the containers: how many times each type was constructed, copied, moved, assigned and destroyed
+// and how many bytes it allocated. This replaces the cout calls that used to be in the cntrs (every cout takes the stream
+// lock so they serialized everything that touched a vector).
+// Build with -DBRAINTRAIN_LIFECYCLE (cmake -DBRAINTRAIN_LIFECYCLE=ON) to turn it on; otherwise every hook is an empty
+// inline function behind 'if constexpr' and compiles to nothing.
+// When on, the counts go to thread_local counters (no atomics or locks on the hot path), are folded into the per-type totals
+// when the thread exits, and a report is printed to cerr at exit.
+namespace lifecycle {
+#ifdef BRAINTRAIN_LIFECYCLE
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    struct Counts {
+        long constructed = 0;
+        long copied = 0;
+        long moved = 0;
+        long copy_assigned = 0;
+        long move_assigned = 0;
+        long destroyed = 0;
+        long bytes_allocated = 0;
+    };
+
+    // the totals of one type across all the threads that have flushed their counters
+    struct Totals {
+        std::string type_name;
+        std::atomic<long> constructed {0};
+        std::atomic<long> copied {0};
+        std::atomic<long> moved {0};
+        std::atomic<long> copy_assigned {0};
+        std::atomic<long> move_assigned {0};
+        std::atomic<long> destroyed {0};
+        std::atomic<long> bytes_allocated {0};
+
+        void add(const Counts &c) {
+            constructed.fetch_add(c.constructed, std::memory_order_relaxed);
+            copied.fetch_add(c.copied, std::memory_order_relaxed);
+            moved.fetch_add(c.moved, std::memory_order_relaxed);
+            copy_assigned.fetch_add(c.copy_assigned, std::memory_order_relaxed);
+            move_assigned.fetch_add(c.move_assigned, std::memory_order_relaxed);
+            destroyed.fetch_add(c.destroyed, std::memory_order_relaxed);
+            bytes_allocated.fetch_add(c.bytes_allocated, std::memory_order_relaxed);
+        }
+    };
+
+    inline std::string demangle(const char *name) {
+#if __has_include(<cxxabi.h>)
+        int status = 0;
+        char *readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        if (status == 0 && readable) {
+            std::string result {readable};
+            std::free(readable);
+            return result;
+        }
+#endif
+        return name;
+    }
+
+    // holds the Totals of every tracked type. A deque so that the references handed out stay valid as types are added
+    class Registry {
+    private:
+        std::mutex mtx;
+        std::deque<Totals> all;
+    public:
+        Totals &add(const char *mangled) {
+            std::scoped_lock sl {mtx};
+            Totals &t = all.emplace_back();
+            t.type_name = demangle(mangled);
+            return t;
+        }
+
+        void report(std::ostream &os) {
+            std::scoped_lock sl {mtx};
+            os << "lifecycle report:" << std::endl;
+            os << std::setw(10) << "ctor" << std::setw(10) << "copy" << std::setw(10) << "move" << std::setw(10) << "copy="
+               << std::setw(10) << "move=" << std::setw(10) << "dtor" << std::setw(14) << "bytes" << "  type" << std::endl;
+            for (const Totals &t : all) { // the type names of templates are long so they go last
+                os << std::setw(10) << t.constructed << std::setw(10) << t.copied << std::setw(10) << t.moved
+                   << std::setw(10) << t.copy_assigned << std::setw(10) << t.move_assigned << std::setw(10) << t.destroyed
+                   << std::setw(14) << t.bytes_allocated << "  " << t.type_name << std::endl;
+            }
+        }
+
+        // static objects are destroyed after the thread_local counters of the main thread are flushed (the standard
+        // guarantees that order) so the report at exit is complete for main and for every thread that was joined
+        ~Registry() {
+            if (!all.empty()) {
+                report(std::cerr);
+            }
+        }
+    };
+
+    inline Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    template<typename T>
+    Totals &totals() {
+        static Totals &t = registry().add(typeid(T).name());
+        return t;
+    }
+
+    // every thread keeps a plain Counts per type and links them so report() can flush the current thread on demand
+    struct LocalBase {
+        LocalBase *next = nullptr;
+
+        virtual void flush() = 0;
+
+        virtual ~LocalBase() = default;
+    };
+
+    inline LocalBase *&thread_locals() {
+        thread_local LocalBase *head = nullptr;
+        return head;
+    }
+
+    template<typename T>
+    struct Local : LocalBase {
+        Counts counts;
+
+        Local() {
+            totals<T>(); // registers the type (and the registry) up front rather than at thread exit
+            next = thread_locals();
+            thread_locals() = this;
+        }
+
+        void flush() override {
+            totals<T>().add(counts);
+            counts = {};
+        }
+
+        ~Local() override { flush(); }
+    };
+
+    template<typename T>
+    Counts &local() {
+        thread_local Local<T> l;
+        return l.counts;
+    }
+
+    // the hooks the containers call. The bytes are what the operation allocated on the heap (0 when nothing was)
+    template<typename T>
+    inline void constructed(long bytes = 0) noexcept {
+        if constexpr (enabled) {
+            Counts &c = local<T>();
+            c.constructed++;
+            c.bytes_allocated += bytes;
+        }
+    }
+
+    template<typename T>
+    inline void copied(long bytes = 0) noexcept {
+        if constexpr (enabled) {
+            Counts &c = local<T>();
+            c.copied++;
+            c.bytes_allocated += bytes;
+        }
+    }
+
+    template<typename T>
+    inline void moved() noexcept {
+        if constexpr (enabled) {
+            local<T>().moved++;
+        }
+    }
+
+    template<typename T>
+    inline void copy_assigned(long bytes = 0) noexcept {
+        if constexpr (enabled) {
+            Counts &c = local<T>();
+            c.copy_assigned++;
+            c.bytes_allocated += bytes;
+        }
+    }
+
+    template<typename T>
+    inline void move_assigned() noexcept {
+        if constexpr (enabled) {
+            local<T>().move_assigned++;
+        }
+    }
+
+    template<typename T>
+    inline void destroyed() noexcept {
+        if constexpr (enabled) {
+            local<T>().destroyed++;
+        }
+    }
+
+    // for the odd allocation that is not a cntr/assignment (a vector growing for example)
+    template<typename T>
+    inline void allocated(long bytes) noexcept {
+        if constexpr (enabled) {
+            local<T>().bytes_allocated += bytes;
+        }
+    }
+
+    // print the counts so far: the current thread is flushed first, other threads only show up once they have exited
+    inline void report(std::ostream &os) {
+        if constexpr (enabled) {
+            for (LocalBase *l = thread_locals(); l; l = l->next) {
+                l->flush();
+            }
+            registry().report(os);
+        }
+    }
+}
+
+#endif //BRAINTRAIN_LIFECYCLE_H
@@ -0,0 +1,153 @@
+#ifndef BRAINTRAIN_SYMBOL_H
+#define BRAINTRAIN_SYMBOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// interned strings: every distinct name is stored once in a process-wide table and a Symbol is its 4-byte index there.
+// Two symbols are equal exactly when their strings are, so == and hashing are an integer compare instead of a string
+// compare, and a million records that repeat a few thousand names hold a million ints instead of a million strings
+// (32 bytes each plus a heap block for anything longer than 15 chars).
+// The table only grows: a name stays interned until the process exits, so intern names and not arbitrary user input.
+// Interning takes a shared lock to look the name up (the common case: a name seen before) and the exclusive lock only to
+// add a new one. Turning a symbol back into its string takes no lock at all: the strings sit in fixed-size chunks that
+// never move, found thru an array of chunk pointers that is itself never reallocated
+class SymbolTable {
+public:
+    static constexpr std::uint32_t chunk_bits = 12;
+    static constexpr std::uint32_t chunk_size = 1u << chunk_bits; // strings per chunk
+    static constexpr std::uint32_t max_chunks = 1u << 14; // 64M distinct strings
+
+    SymbolTable() { intern(""); } // the empty string is id 0: what a default Symbol holds
+
+    SymbolTable(const SymbolTable &) = delete;
+
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    ~SymbolTable() {
+        for (auto &chunk : chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    // the id of s, adding it if it was never seen
+    std::uint32_t intern(std::string_view s) {
+        {
+            std::shared_lock lock {mtx};
+            if (auto found = ids.find(s); found != ids.end()) {
+                return found->second;
+            }
+        }
+        std::unique_lock lock {mtx};
+        if (auto found = ids.find(s); found != ids.end()) { // another thread added it between the two locks
+            return found->second;
+        }
+        if (count == chunk_size * max_chunks) {
+            throw std::length_error("symbol table full");
+        }
+        std::uint32_t id = count;
+        std::atomic<std::string *> &slot = chunks[id >> chunk_bits];
+        std::string *chunk = slot.load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new std::string[chunk_size];
+            slot.store(chunk, std::memory_order_release);
+        }
+        std::string &stored = chunk[id & (chunk_size - 1)];
+        stored = s;
+        ids.emplace(std::string_view {stored}, id); // the key views the stored string, which never moves
+        chars += s.size();
+        ++count;
+        return id;
+    }
+
+    // the string of an id handed out by intern. Whoever got the id from intern (or from a thread that did) is ordered
+    // after the string was written, so no lock is needed
+    [[nodiscard]] const std::string &str(std::uint32_t id) const {
+        return chunks[id >> chunk_bits].load(std::memory_order_acquire)[id & (chunk_size - 1)];
+    }
+
+    [[nodiscard]] std::uint32_t size() const {
+        std::shared_lock lock {mtx};
+        return count;
+    }
+
+    // the characters stored, a rough measure of what interning keeps out of the records
+    [[nodiscard]] std::size_t char_count() const {
+        std::shared_lock lock {mtx};
+        return chars;
+    }
+
+    // the process-wide table. Never destroyed so that symbols stay readable in destructors of other statics at exit
+    static SymbolTable &global() {
+        static SymbolTable *table = new SymbolTable;
+        return *table;
+    }
+
+private:
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    std::atomic<std::string *> chunks[max_chunks] {};
+    std::uint32_t count = 0;
+    std::size_t chars = 0;
+};
+
+// a name as a 4-byte handle into the global table. Converts implicitly from a string like std::string converts from a
+// char* (Planet {"Mars"} still works), so an interned field is a drop-in for a string field that is only compared,
+// hashed and printed.
+// The flip side of the implicit conversion: constructing a Symbol interns its string for good, so build them from a known
+// set of names and not from user input or numbers formatted in a loop. Comparing with a string does not construct one:
+// get_name() == "x" compares the characters and leaves the table alone
+class Symbol {
+public:
+    Symbol() = default; // ""
+
+    Symbol(std::string_view s): id {SymbolTable::global().intern(s)} {}
+
+    Symbol(const char *s): Symbol(std::string_view {s}) {}
+
+    Symbol(const std::string &s): Symbol(std::string_view {s}) {}
+
+    [[nodiscard]] const std::string &str() const { return SymbolTable::global().str(id); }
+
+    [[nodiscard]] std::string_view view() const { return str(); }
+
+    [[nodiscard]] std::uint32_t get_id() const { return id; }
+
+    [[nodiscard]] bool empty() const { return id == 0; }
+
+    // the same id is the same string: no characters are compared. There is no < - ids are in order of first use, not
+    // alphabetical: compare str() for that
+    friend bool operator==(Symbol a, Symbol b) { return a.id == b.id; }
+
+    // against a string the characters are compared (a lock-free str()), so nothing is interned. The char* and string
+    // overloads are there because both would convert to Symbol and to string_view alike, an ambiguous call
+    friend bool operator==(Symbol a, std::string_view s) { return a.view() == s; }
+
+    friend bool operator==(Symbol a, const char *s) { return a.view() == s; }
+
+    friend bool operator==(Symbol a, const std::string &s) { return a.view() == s; }
+
+private:
+    std::uint32_t id = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &os, Symbol s) {
+    return os << s.view();
+}
+
+// the id is already unique per string: use it as the hash
+template<>
+struct std::hash<Symbol> {
+    std::size_t operator()(Symbol s) const noexcept { return s.get_id(); }
+};
+
+#endif //BRAINTRAIN_SYMBOL_H
@@ -7,11 +7,14 @@
 #include <iterator>
 #include <forward_list>
 #include <fstream>
+#include <memory>
+#include <algorithm>
+#include "../common/headers/Symbol.h"
 
 using namespace std;
 
 struct Planet {
-    string name;
+    Symbol name;
     int diameter = 0;
 
     bool operator==(const Planet &other) const {
@@ -1,6 +1,12 @@
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
+#include "../common/headers/Symbol.h"
+#include "headers/ObjectPool.h"
 
 using namespace std;
 
@@ -51,14 +57,15 @@ void immutable_string() {
 }
 
 // note this class and the testing done on it is improvisation on my part so it is not the bible especially with a complicated language like this
+// the name is a Symbol: moving or copying it copies an int, there is no buffer to steal
 class village {
 public:
-    village(string name, int population): name{std::move(name)}, population{population} {}
+    village(Symbol name, int population): name{name}, population{population} {} // a string or a char* is interned on the way in
     // move-cntr
-    village(village&& other) noexcept: name{move(other.name)}, population{other.population} {
+    village(village&& other) noexcept: name{other.name}, population{other.population} {
         cout << "called move-cntr" << endl;
         // set moved-from to sensible values
-        other.name = "";
+        other.name = Symbol {}; // ""
         other.population = 0;
     }
 
@@ -68,23 +75,23 @@ public:
         this-> name = other.name;
         this->population = other.population;
 
-        other.name = "";
+        other.name = Symbol {}; // ""
         other.population = 0;
 
         return *this;
     }
-    [[nodiscard]] string get_name() const {return name;}
+    [[nodiscard]] Symbol get_name() const {return name;}
     [[nodiscard]] int get_population() const {return population;}
 
-    void set_name(string nm) { // using 'name' gives a warning that it shadows the member field (that's not a problem in Java)
-        this->name = std::move(nm);
+    void set_name(Symbol nm) { // using 'name' gives a warning that it shadows the member field (that's not a problem in Java)
+        this->name = nm;
     }
 
     void set_population(int pop) {
         this->population = pop;
     }
 private:
-    string name;
+    Symbol name;
     int population;
 };
 
@@ -98,15 +105,21 @@ village create_village1(string name, int population) {
 }
 
 // this should only copy the value of the pointer at return (I think): must mean that the unique_ptr creates the village on the heap (cannot be on the func stack)
-unique_ptr<village> create_village2(string name, int population) {
-    auto village_ptr = make_unique<village>(village{std::move(name), population});
+// the village comes from the village pool (headers/ObjectPool.h) instead of new: make_pooled is make_unique with a deleter
+// that gives the block back to the pool. It builds the village in place from the args (make_unique<village>(village{...})
+// built a temporary and moved it)
+pooled_ptr<village> create_village2(string name, int population) {
+    auto village_ptr = make_pooled<village>(name, population);
     cout << "v2_ptr: "<< village_ptr << endl;
     return village_ptr;
 }
 
-unique_ptr<village> create_village3(string name, int population) {
-    // this is equivalent to what is done in create_village2 (Clang-Tidy urges using make_unique tho so we should not do that)
-    auto village_ptr = unique_ptr<village>(new village(std::move(name), population));
+pooled_ptr<village> create_village3(string name, int population) {
+    // this is equivalent to what is done in create_village2, spelled out like unique_ptr<village>(new village(...)) was:
+    // a raw block, the village constructed into it, the pointer handed to a pooled_ptr. Unlike make_pooled it loses the
+    // block if the constructor throws, which is why make_pooled (like make_unique) is preferred
+    void *block = ObjectPool<village>::allocate();
+    auto village_ptr = pooled_ptr<village>(new (block) village(name, population));
     cout << "v3_ptr: "<< village_ptr << endl;
     return village_ptr;
 }
@@ -116,11 +129,11 @@ void village_tester() {
     village v1 = create_village1("Cold Spring", 10000);
     cout << "village1: " << v1 << endl;
 
-    unique_ptr<village> v2 = create_village2("Peeks Kill", 4500);
+    pooled_ptr<village> v2 = create_village2("Peeks Kill", 4500);
     cout << "v2_ptr: " << v2 << endl; // this prints the same memory address as in create_village2
     cout << "village2: " << *v2 << endl;
 
-    unique_ptr<village> v3 = create_village3("Haverstraw", 6000);
+    pooled_ptr<village> v3 = create_village3("Haverstraw", 6000);
     cout << "v3_ptr: " << v3 << endl; // this prints the same memory address as in create_village3
     cout << "village3: " << *v3 << endl;
 
@@ -155,11 +168,53 @@ void string_style_c_vs_cpp() {
     cout << s3[0] << endl;
 }
 
+// villages created and destroyed at a high rate: every thread keeps a window of 1000 live villages and replaces the oldest
+// one over and over, with make_unique (malloc and free) and with make_pooled (the village pool)
+void village_pool_benchmark() {
+    cout << "village_pool_benchmark" << endl;
+    using namespace chrono;
+    const int rounds = 1'000'000;
+    const int window = 1000;
+    const Symbol names[] = {"Cold Spring", "Peeks Kill", "Haverstraw", "Nyack", "Piermont"}; // interned up front
+
+    auto churn = [&](auto make) {
+        decltype(make(0)) live[window];
+        long total = 0;
+        for (int i = 0; i != rounds; i++) {
+            live[i % window] = make(i); // the village that was there is destroyed
+            total += live[i % window]->get_population();
+        }
+        return total;
+    };
+    auto time_it = [&](const string &name, int threads, auto make) {
+        vector<thread> workers;
+        vector<long> totals(threads);
+        auto t1 = high_resolution_clock::now();
+        for (int t = 0; t != threads; t++) {
+            workers.emplace_back([&, t] { totals[t] = churn(make); });
+        }
+        for (thread &w : workers) {
+            w.join();
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << " x" << threads << " threads: " << duration<double, milli>(t2 - t1).count() << " ms (" << totals[0]
+             << ")" << endl;
+    };
+    for (int threads : {1, 4}) {
+        time_it("make_unique", threads, [&](int i) { return make_unique<village>(names[i % 5], i % 5000); });
+        time_it("make_pooled", threads, [&](int i) { return make_pooled<village>(names[i % 5], i % 5000); });
+    }
+    N::slab::Stats stats = ObjectPool<village>::stats();
+    cout << "pool: " << stats.slabs << " slabs, " << stats.allocations << " allocations, " << stats.hit_rate() * 100
+         << "% from the thread cache, " << stats.refills << " refills" << endl;
+}
+
 int main() {
     mutable_string();
     string_style_c_vs_cpp();
     immutable_string();
     village_tester();
+    village_pool_benchmark();
 
     return 0;
 }
@@ -0,0 +1,69 @@
+#ifndef BRAINTRAIN_OBJECTPOOL_H
+#define BRAINTRAIN_OBJECTPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include "../../einstein/headers/Slab.h"
+
+// blocks the size of one T for objects that are created and destroyed at a high rate and handed out as unique_ptrs.
+// make_pooled<T>(args...) is make_unique<T>(args...) with a different deleter: the deleter runs ~T and gives the block
+// back instead of calling delete, so after warm up creating an object is a pop and destroying it a push, with no malloc
+// or free.
+// The blocks come from the small slabs of einstein (einstein/headers/Slab.h), the ones the Vector buffers use: a size
+// class per power of 2 up to 1 KiB, a free list per class, and a cache of free blocks per thread that only takes the
+// class's lock to move a batch in or out. An object can be destroyed on another thread than the one that created it: the
+// block joins the cache of the destroying thread.
+// The block size is fixed by the type, so the deleter is empty and a pooled_ptr is the size of a plain pointer
+template<typename T>
+class ObjectPool {
+    static_assert(sizeof(T) <= 1024, "the small slab blocks are at most 1 KiB");
+    static_assert(alignof(T) <= 64, "the slab blocks are aligned on 64 bytes");
+public:
+    // not noexcept of its own: giving the block back takes the slab's lock when the thread's cache is full. slab::deallocate
+    // is noexcept, so a failure there ends the program like any exception out of a destructor would
+    struct Deleter {
+        void operator()(T *p) const {
+            p->~T();
+            deallocate(p);
+        }
+    };
+
+    using Ptr = std::unique_ptr<T, Deleter>;
+
+    template<typename... Args>
+    static Ptr make(Args &&... args) {
+        void *block = allocate();
+        try {
+            return Ptr(new(block) T(std::forward<Args>(args)...));
+        } catch (...) {
+            deallocate(block); // the constructor threw: no object to destroy, just the block to return
+            throw;
+        }
+    }
+
+    // an uninitialized block for one T. Pair with deallocate, or construct into it and hand it to a Ptr
+    static void *allocate() {
+        return N::slab::allocate(sizeof(T), N::Category::small);
+    }
+
+    static void deallocate(void *p) {
+        N::slab::deallocate(p, sizeof(T), N::Category::small);
+    }
+
+    // the small slabs are shared by every pooled type and the small Vectors: the counts are theirs, not only T's
+    static N::slab::Stats stats() {
+        return N::slab::stats(N::Category::small);
+    }
+};
+
+template<typename T>
+using pooled_ptr = typename ObjectPool<T>::Ptr;
+
+template<typename T, typename... Args>
+pooled_ptr<T> make_pooled(Args &&... args) {
+    return ObjectPool<T>::make(std::forward<Args>(args)...);
+}
+
+#endif //BRAINTRAIN_OBJECTPOOL_H
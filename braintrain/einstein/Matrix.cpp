@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "headers/Matrix.h"
+#include "headers/Reduce.h"
+#include "../common/headers/Dispatch.h"
+
+#ifdef BRAINTRAIN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace N {
+namespace {
+    // the micro-kernel computes an MR x NR tile of c; the blocks are sized for the caches: a KC x NC panel of b (2 MiB)
+    // sits in L3/L2, an MC x KC block of a (256 KiB) in L2, and a KC x NR strip of b (16 KiB) in L1
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    constexpr int MC = 128;
+    constexpr int KC = 256;
+    constexpr int NC = 1024;
+
+    // r * c as the length of the storage, checked before anything is allocated: the product is taken in long so a
+    // 65536 x 65536 matrix is refused instead of wrapping to 0 doubles
+    int checked_size(int r, int c) {
+        if (r < 0 || c < 0) {
+            throw length_error("negative matrix shape: " + to_string(r) + " x " + to_string(c));
+        }
+        long n = static_cast<long>(r) * c;
+        if (n > numeric_limits<int>::max()) {
+            throw length_error("matrix too large: " + to_string(r) + " x " + to_string(c));
+        }
+        return static_cast<int>(n);
+    }
+
+    int thread_count(int threads, double flops) {
+        if (threads <= 0) {
+            threads = static_cast<int>(max(1u, thread::hardware_concurrency()));
+        }
+        // a thread costs tens of microseconds to start: not worth it below a few million flops each
+        return max(1, min(threads, static_cast<int>(flops / 4e6)));
+    }
+
+    // runs work(begin, end) over [0, n) split in threads contiguous ranges (each a multiple of step), the calling thread
+    // taking the first one
+    template<typename F>
+    void parallel_for(int n, int step, int threads, F work) {
+        int per = (n + threads - 1) / threads;
+        per = (per + step - 1) / step * step;
+        vector<thread> workers;
+        for (int b = per; b < n; b += per) {
+            workers.emplace_back(work, b, min(n, b + per));
+        }
+        work(0, min(n, per));
+        for (thread &w : workers) {
+            w.join();
+        }
+    }
+
+    // packs rows [i0, i0 + mc) x cols [p0, p0 + kc) of a into strips of MR rows: strip s, column k holds
+    // a(i0 + s*MR .. +MR, p0 + k) next to each other. Rows past the end are zeroes
+    void pack_a(const Matrix &a, int i0, int mc, int p0, int kc, double *out) {
+        for (int s = 0; s < mc; s += MR) {
+            for (int k = 0; k != kc; k++) {
+                for (int r = 0; r != MR; r++) {
+                    *out++ = s + r < mc ? a(i0 + s + r, p0 + k) : 0.0;
+                }
+            }
+        }
+    }
+
+    // packs rows [p0, p0 + kc) x cols [j0, j0 + nc) of b into strips of NR columns: strip s, row k holds
+    // b(p0 + k, j0 + s*NR .. +NR). Columns past the end are zeroes
+    void pack_b(const Matrix &b, int p0, int kc, int j0, int nc, double *out) {
+        for (int s = 0; s < nc; s += NR) {
+            int w = min(NR, nc - s);
+            for (int k = 0; k != kc; k++) {
+                const double *src = b.row(p0 + k) + j0 + s;
+                for (int c = 0; c != w; c++) {
+                    out[c] = src[c];
+                }
+                for (int c = w; c != NR; c++) {
+                    out[c] = 0.0;
+                }
+                out += NR;
+            }
+        }
+    }
+
+    // tile = packed a strip (kc x MR) times packed b strip (kc x NR)
+    void micro_scalar(int kc, const double *pa, const double *pb, double *tile) {
+        double acc[MR][NR] {};
+        for (int k = 0; k != kc; k++) {
+            for (int r = 0; r != MR; r++) {
+                for (int c = 0; c != NR; c++) {
+                    acc[r][c] += pa[k * MR + r] * pb[k * NR + c];
+                }
+            }
+        }
+        for (int r = 0; r != MR; r++) {
+            for (int c = 0; c != NR; c++) {
+                tile[r * NR + c] = acc[r][c];
+            }
+        }
+    }
+
+#ifdef BRAINTRAIN_X86
+    // the 4 x 8 tile is 8 ymm registers; every k broadcasts 4 values of a and does 8 fma's against 2 loads of b
+    __attribute__((target("avx2,fma")))
+    void micro_avx2(int kc, const double *pa, const double *pb, double *tile) {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        for (int k = 0; k != kc; k++) {
+            __m256d b0 = _mm256_loadu_pd(pb + k * NR), b1 = _mm256_loadu_pd(pb + k * NR + 4);
+            __m256d a0 = _mm256_broadcast_sd(pa + k * MR), a1 = _mm256_broadcast_sd(pa + k * MR + 1);
+            c00 = _mm256_fmadd_pd(a0, b0, c00);
+            c01 = _mm256_fmadd_pd(a0, b1, c01);
+            c10 = _mm256_fmadd_pd(a1, b0, c10);
+            c11 = _mm256_fmadd_pd(a1, b1, c11);
+            __m256d a2 = _mm256_broadcast_sd(pa + k * MR + 2), a3 = _mm256_broadcast_sd(pa + k * MR + 3);
+            c20 = _mm256_fmadd_pd(a2, b0, c20);
+            c21 = _mm256_fmadd_pd(a2, b1, c21);
+            c30 = _mm256_fmadd_pd(a3, b0, c30);
+            c31 = _mm256_fmadd_pd(a3, b1, c31);
+        }
+        _mm256_storeu_pd(tile, c00);
+        _mm256_storeu_pd(tile + 4, c01);
+        _mm256_storeu_pd(tile + 8, c10);
+        _mm256_storeu_pd(tile + 12, c11);
+        _mm256_storeu_pd(tile + 16, c20);
+        _mm256_storeu_pd(tile + 20, c21);
+        _mm256_storeu_pd(tile + 24, c30);
+        _mm256_storeu_pd(tile + 28, c31);
+    }
+#endif
+
+    using Micro = void (*)(int, const double *, const double *, double *);
+
+    // picked like the reductions (avx-512 machines run the avx2 kernel)
+    Micro micro_kernel() {
+        static cpu::Dispatch<Micro> d {
+                {cpu::Isa::scalar, micro_scalar},
+#ifdef BRAINTRAIN_X86
+                {cpu::Isa::avx2, micro_avx2},
+#endif
+        };
+        return d.kernels();
+    }
+
+    // c rows [r0, r1) += alpha * a rows [r0, r1) * b
+    void gemm_rows(const Matrix &a, const Matrix &b, Matrix &c, double alpha, int r0, int r1) {
+        const int n = b.get_cols(), k_all = a.get_cols();
+        Micro micro = micro_kernel();
+        vector<double> packed_b(static_cast<size_t>(KC) * ((NC + NR - 1) / NR * NR));
+        vector<double> packed_a(static_cast<size_t>(KC) * MC);
+        double tile[MR * NR];
+        for (int jc = 0; jc < n; jc += NC) {
+            int nc = min(NC, n - jc);
+            for (int pc = 0; pc < k_all; pc += KC) {
+                int kc = min(KC, k_all - pc);
+                pack_b(b, pc, kc, jc, nc, packed_b.data());
+                for (int ic = r0; ic < r1; ic += MC) {
+                    int mc = min(MC, r1 - ic);
+                    pack_a(a, ic, mc, pc, kc, packed_a.data());
+                    for (int jr = 0; jr < nc; jr += NR) {
+                        int w = min(NR, nc - jr);
+                        const double *pb = packed_b.data() + static_cast<size_t>(jr) * kc;
+                        for (int ir = 0; ir < mc; ir += MR) {
+                            int h = min(MR, mc - ir);
+                            micro(kc, packed_a.data() + static_cast<size_t>(ir) * kc, pb, tile);
+                            for (int r = 0; r != h; r++) {
+                                double *dst = c.row(ic + ir + r) + jc + jr;
+                                for (int col = 0; col != w; col++) {
+                                    dst[col] += alpha * tile[r * NR + col];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+Matrix::Matrix(int r, int c) : rows {r}, cols {c}, storage {checked_size(r, c), category_for(r * c)} {
+    fill_n(storage.data(), storage.get_size(), 0.0); // Vector(int, Category) leaves the doubles uninitialized
+}
+
+Matrix::Matrix(initializer_list<initializer_list<double>> init)
+        : Matrix(static_cast<int>(init.size()), init.size() ? static_cast<int>(init.begin()->size()) : 0) {
+    int r = 0;
+    for (const initializer_list<double> &row : init) {
+        if (static_cast<int>(row.size()) != cols) {
+            throw length_error("row " + to_string(r) + " has " + to_string(row.size()) + " values, expected " + to_string(cols));
+        }
+        copy(row.begin(), row.end(), this->row(r));
+        r++;
+    }
+}
+
+Matrix Matrix::identity(int n) {
+    Matrix m(n, n);
+    for (int i = 0; i != n; i++) {
+        m(i, i) = 1;
+    }
+    return m;
+}
+
+double &Matrix::at(int r, int c) {
+    if (r < 0 || r >= rows || c < 0 || c >= cols) {
+        throw out_of_range("(" + to_string(r) + ", " + to_string(c) + ") outside a " + to_string(rows) + " x " + to_string(cols) + " matrix");
+    }
+    return (*this)(r, c);
+}
+
+void gemm(const Matrix &a, const Matrix &b, Matrix &c, double alpha, double beta, int threads) {
+    if (a.get_cols() != b.get_rows() || c.get_rows() != a.get_rows() || c.get_cols() != b.get_cols()) {
+        throw length_error("gemm shapes do not fit: " + to_string(a.get_rows()) + "x" + to_string(a.get_cols()) + " * " +
+                           to_string(b.get_rows()) + "x" + to_string(b.get_cols()) + " -> " + to_string(c.get_rows()) +
+                           "x" + to_string(c.get_cols()));
+    }
+    const int m = a.get_rows();
+    double *cd = c.data();
+    long cn = static_cast<long>(c.get_rows()) * c.get_cols();
+    if (beta == 0) {
+        fill_n(cd, cn, 0.0); // not 0 * c: that would keep NaNs in c
+    } else if (beta != 1) {
+        for (long i = 0; i != cn; i++) {
+            cd[i] *= beta;
+        }
+    }
+    if (a.get_cols() == 0 || alpha == 0) {
+        return;
+    }
+    // every thread gets its own rows of c (and a): nothing is shared but a and b, which are only read
+    int t = thread_count(threads, 2.0 * m * b.get_cols() * a.get_cols());
+    parallel_for(m, MR, t, [&](int r0, int r1) { gemm_rows(a, b, c, alpha, r0, r1); });
+}
+
+void gemm_naive(const Matrix &a, const Matrix &b, Matrix &c) {
+    if (a.get_cols() != b.get_rows() || c.get_rows() != a.get_rows() || c.get_cols() != b.get_cols()) {
+        throw length_error("gemm shapes do not fit");
+    }
+    for (int i = 0; i != a.get_rows(); i++) {
+        for (int j = 0; j != b.get_cols(); j++) {
+            double s = 0;
+            for (int k = 0; k != a.get_cols(); k++) {
+                s += a(i, k) * b(k, j);
+            }
+            c(i, j) = s;
+        }
+    }
+}
+
+// every row is a dot product with x: the simd dot of Reduce.h
+void gemv(const Matrix &a, const double *x, double *y, double alpha, double beta, int threads) {
+    const int m = a.get_rows(), n = a.get_cols();
+    int t = thread_count(threads, 2.0 * m * n);
+    parallel_for(m, 1, t, [&](int r0, int r1) {
+        for (int r = r0; r != r1; r++) {
+            double d = n ? simd::dot(a.row(r), x, n) : 0.0;
+            y[r] = beta == 0 ? alpha * d : alpha * d + beta * y[r];
+        }
+    });
+}
+
+// 32 x 32 tiles: a tile of the source rows and of the destination rows both stay in L1 while it is copied
+Matrix transpose(const Matrix &a, int threads) {
+    constexpr int tile = 32;
+    const int m = a.get_rows(), n = a.get_cols();
+    Matrix t(n, m);
+    int th = thread_count(threads, 20.0 * m * n); // memory bound: weigh the copies more than flops
+    parallel_for(m, tile, th, [&](int r0, int r1) {
+        for (int i0 = r0; i0 < r1; i0 += tile) {
+            for (int j0 = 0; j0 < n; j0 += tile) {
+                int i1 = min(r1, i0 + tile), j1 = min(n, j0 + tile);
+                for (int i = i0; i != i1; i++) {
+                    for (int j = j0; j != j1; j++) {
+                        t(j, i) = a(i, j);
+                    }
+                }
+            }
+        }
+    });
+    return t;
+}
+
+Matrix operator*(const Matrix &a, const Matrix &b) {
+    Matrix c(a.get_rows(), b.get_cols());
+    gemm(a, b, c);
+    return c;
+}
+
+Vector operator*(const Matrix &a, const Vector &x) {
+    if (x.get_size() != a.get_cols()) {
+        throw length_error("matrix has " + to_string(a.get_cols()) + " cols but the vector " + to_string(x.get_size()) + " values");
+    }
+    Vector y(a.get_rows());
+    gemv(a, x.data(), y.data());
+    return y;
+}
+}
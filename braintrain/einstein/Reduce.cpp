@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "headers/Reduce.h"
+
+#ifdef BRAINTRAIN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace N::simd {
+namespace { // the kernels are implementation details: only the dispatching functions at the bottom are exported
+
+    // one table of function pointers per instruction set: dispatching costs one indirect call per reduction (not per element)
+    struct Kernels {
+        double (*sum)(const double *, int);
+        double (*dot)(const double *, const double *, int);
+        double (*min)(const double *, int);
+        double (*max)(const double *, int);
+    };
+
+    // scalar kernels: also used for the tails the vector loops leave behind
+    double sum_scalar(const double *p, int n) {
+        double s = 0;
+        for (int i = 0; i != n; ++i) {
+            s += p[i];
+        }
+        return s;
+    }
+
+    double dot_scalar(const double *a, const double *b, int n) {
+        double s = 0;
+        for (int i = 0; i != n; ++i) {
+            s += a[i] * b[i];
+        }
+        return s;
+    }
+
+    double min_scalar(const double *p, int n) {
+        return *min_element(p, p + n);
+    }
+
+    double max_scalar(const double *p, int n) {
+        return *max_element(p, p + n);
+    }
+
+#ifdef BRAINTRAIN_X86
+    // every loop keeps 4 independent accumulators so the adds are not serialized on the latency of a single register
+
+    __attribute__((target("sse2")))
+    double hsum128(__m128d v) {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
+
+    __attribute__((target("sse2")))
+    double sum_sse2(const double *p, int n) {
+        __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd(), a2 = _mm_setzero_pd(), a3 = _mm_setzero_pd();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            a0 = _mm_add_pd(a0, _mm_loadu_pd(p + i));
+            a1 = _mm_add_pd(a1, _mm_loadu_pd(p + i + 2));
+            a2 = _mm_add_pd(a2, _mm_loadu_pd(p + i + 4));
+            a3 = _mm_add_pd(a3, _mm_loadu_pd(p + i + 6));
+        }
+        return hsum128(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3))) + sum_scalar(p + i, n - i);
+    }
+
+    __attribute__((target("sse2")))
+    double dot_sse2(const double *a, const double *b, int n) {
+        __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd(), a2 = _mm_setzero_pd(), a3 = _mm_setzero_pd();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+            a2 = _mm_add_pd(a2, _mm_mul_pd(_mm_loadu_pd(a + i + 4), _mm_loadu_pd(b + i + 4)));
+            a3 = _mm_add_pd(a3, _mm_mul_pd(_mm_loadu_pd(a + i + 6), _mm_loadu_pd(b + i + 6)));
+        }
+        return hsum128(_mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3))) + dot_scalar(a + i, b + i, n - i);
+    }
+
+    __attribute__((target("sse2")))
+    double min_sse2(const double *p, int n) {
+        if (n < 2) {
+            return min_scalar(p, n);
+        }
+        __m128d m = _mm_loadu_pd(p);
+        int i = 2;
+        for (; i + 2 <= n; i += 2) {
+            m = _mm_min_pd(m, _mm_loadu_pd(p + i));
+        }
+        double r = _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+        return i == n ? r : std::min(r, min_scalar(p + i, n - i));
+    }
+
+    __attribute__((target("sse2")))
+    double max_sse2(const double *p, int n) {
+        if (n < 2) {
+            return max_scalar(p, n);
+        }
+        __m128d m = _mm_loadu_pd(p);
+        int i = 2;
+        for (; i + 2 <= n; i += 2) {
+            m = _mm_max_pd(m, _mm_loadu_pd(p + i));
+        }
+        double r = _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+        return i == n ? r : std::max(r, max_scalar(p + i, n - i));
+    }
+
+    __attribute__((target("avx2")))
+    double hsum256(__m256d v) {
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+
+    __attribute__((target("avx2")))
+    double hmin256(__m256d v) {
+        __m128d h = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+
+    __attribute__((target("avx2")))
+    double hmax256(__m256d v) {
+        __m128d h = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+
+    __attribute__((target("avx2")))
+    double sum_avx2(const double *p, int n) {
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(), a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+            a1 = _mm256_add_pd(a1, _mm256_loadu_pd(p + i + 4));
+            a2 = _mm256_add_pd(a2, _mm256_loadu_pd(p + i + 8));
+            a3 = _mm256_add_pd(a3, _mm256_loadu_pd(p + i + 12));
+        }
+        return hsum256(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3))) + sum_scalar(p + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    double dot_avx2(const double *a, const double *b, int n) {
+        __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(), a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 16 <= n; i += 16) {
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), a0);
+            a1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), a1);
+            a2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), a2);
+            a3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), a3);
+        }
+        return hsum256(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3))) + dot_scalar(a + i, b + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    double min_avx2(const double *p, int n) {
+        if (n < 4) {
+            return min_scalar(p, n);
+        }
+        __m256d m = _mm256_loadu_pd(p);
+        int i = 4;
+        for (; i + 4 <= n; i += 4) {
+            m = _mm256_min_pd(m, _mm256_loadu_pd(p + i));
+        }
+        double r = hmin256(m);
+        return i == n ? r : std::min(r, min_scalar(p + i, n - i));
+    }
+
+    __attribute__((target("avx2")))
+    double max_avx2(const double *p, int n) {
+        if (n < 4) {
+            return max_scalar(p, n);
+        }
+        __m256d m = _mm256_loadu_pd(p);
+        int i = 4;
+        for (; i + 4 <= n; i += 4) {
+            m = _mm256_max_pd(m, _mm256_loadu_pd(p + i));
+        }
+        double r = hmax256(m);
+        return i == n ? r : std::max(r, max_scalar(p + i, n - i));
+    }
+
+    // gcc 12 builds _mm512_reduce_*_pd, _mm512_min/max_pd, _mm512_extractf64x4_pd and even _mm512_castpd512_pd256 on an
+    // _mm*_undefined_pd() that warns (uninitialized) under -Wall -Wextra. The masked forms with every lane selected take
+    // an explicit source and compile to the same instructions; the 512-bit registers are folded into 256 bits with them
+    // and finished by the avx2 steps above
+    __attribute__((target("avx512f")))
+    __m256d low256(__m512d v) {
+        return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 0);
+    }
+
+    __attribute__((target("avx512f")))
+    __m256d high256(__m512d v) {
+        return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 1);
+    }
+
+    __attribute__((target("avx512f")))
+    __m256d halves_add(__m512d v) {
+        return _mm256_add_pd(low256(v), high256(v));
+    }
+
+    __attribute__((target("avx512f")))
+    __m512d min512(__m512d a, __m512d b) {
+        return _mm512_mask_min_pd(a, 0xFF, a, b);
+    }
+
+    __attribute__((target("avx512f")))
+    __m512d max512(__m512d a, __m512d b) {
+        return _mm512_mask_max_pd(a, 0xFF, a, b);
+    }
+
+    // avx-512 handles the tail with a mask instead of falling back to the scalar loop
+    __attribute__((target("avx512f")))
+    double sum_avx512(const double *p, int n) {
+        __m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(), a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+        int i = 0;
+        for (; i + 32 <= n; i += 32) {
+            a0 = _mm512_add_pd(a0, _mm512_loadu_pd(p + i));
+            a1 = _mm512_add_pd(a1, _mm512_loadu_pd(p + i + 8));
+            a2 = _mm512_add_pd(a2, _mm512_loadu_pd(p + i + 16));
+            a3 = _mm512_add_pd(a3, _mm512_loadu_pd(p + i + 24));
+        }
+        for (; i < n; i += 8) {
+            __mmask8 mask = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            a0 = _mm512_add_pd(a0, _mm512_maskz_loadu_pd(mask, p + i));
+        }
+        return hsum256(halves_add(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3))));
+    }
+
+    __attribute__((target("avx512f")))
+    double dot_avx512(const double *a, const double *b, int n) {
+        __m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(), a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+        int i = 0;
+        for (; i + 32 <= n; i += 32) {
+            a0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), a0);
+            a1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), a1);
+            a2 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 16), _mm512_loadu_pd(b + i + 16), a2);
+            a3 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 24), _mm512_loadu_pd(b + i + 24), a3);
+        }
+        for (; i < n; i += 8) {
+            __mmask8 mask = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            a0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i), a0);
+        }
+        return hsum256(halves_add(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3))));
+    }
+
+    __attribute__((target("avx512f")))
+    double min_avx512(const double *p, int n) {
+        if (n < 8) {
+            return min_scalar(p, n);
+        }
+        __m512d m = _mm512_loadu_pd(p);
+        int i = 8;
+        for (; i + 8 <= n; i += 8) {
+            m = min512(m, _mm512_loadu_pd(p + i));
+        }
+        double r = hmin256(_mm256_min_pd(low256(m), high256(m)));
+        return i == n ? r : std::min(r, min_scalar(p + i, n - i));
+    }
+
+    __attribute__((target("avx512f")))
+    double max_avx512(const double *p, int n) {
+        if (n < 8) {
+            return max_scalar(p, n);
+        }
+        __m512d m = _mm512_loadu_pd(p);
+        int i = 8;
+        for (; i + 8 <= n; i += 8) {
+            m = max512(m, _mm512_loadu_pd(p + i));
+        }
+        double r = hmax256(_mm256_max_pd(low256(m), high256(m)));
+        return i == n ? r : std::max(r, max_scalar(p + i, n - i));
+    }
+#endif
+
+    // dot_avx2 and the avx-512 kernels use fma: the avx2 level of cpu::detect includes it
+    cpu::Dispatch<Kernels> &dispatch() {
+        static cpu::Dispatch<Kernels> d {
+                {Isa::scalar, {sum_scalar, dot_scalar, min_scalar, max_scalar}},
+#ifdef BRAINTRAIN_X86
+                {Isa::sse2, {sum_sse2, dot_sse2, min_sse2, max_sse2}},
+                {Isa::avx2, {sum_avx2, dot_avx2, min_avx2, max_avx2}},
+                {Isa::avx512, {sum_avx512, dot_avx512, min_avx512, max_avx512}},
+#endif
+        };
+        return d;
+    }
+
+    void check_not_empty(int n) {
+        if (n <= 0) {
+            throw length_error("min/max of an empty vector");
+        }
+    }
+}
+
+    Isa active_isa() noexcept {
+        return dispatch().active();
+    }
+
+    Isa use_isa(Isa isa) noexcept {
+        return dispatch().use(isa);
+    }
+
+    const char *isa_name(Isa isa) noexcept {
+        return cpu::isa_name(isa);
+    }
+
+    double sum(const double *p, int n) {
+        return n > 0 ? dispatch().kernels().sum(p, n) : 0;
+    }
+
+    double dot(const double *a, const double *b, int n) {
+        return n > 0 ? dispatch().kernels().dot(a, b, n) : 0;
+    }
+
+    double min(const double *p, int n) {
+        check_not_empty(n);
+        return dispatch().kernels().min(p, n);
+    }
+
+    double max(const double *p, int n) {
+        check_not_empty(n);
+        return dispatch().kernels().max(p, n);
+    }
+
+    double norm(const double *p, int n) {
+        return sqrt(dot(p, p, n));
+    }
+
+    double sum(const Vector &v) {
+        return sum(v.data(), v.get_size());
+    }
+
+    double dot(const Vector &v1, const Vector &v2) {
+        if (v1.get_size() != v2.get_size()) {
+            throw length_error("dot of vectors with different lengths: " + to_string(v1.get_size()) + " and " + to_string(v2.get_size()));
+        }
+        return dot(v1.data(), v2.data(), v1.get_size());
+    }
+
+    double min(const Vector &v) {
+        return min(v.data(), v.get_size());
+    }
+
+    double max(const Vector &v) {
+        return max(v.data(), v.get_size());
+    }
+
+    double norm(const Vector &v) {
+        return norm(v.data(), v.get_size());
+    }
+}
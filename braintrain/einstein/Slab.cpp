@@ -0,0 +1,314 @@
+#include <atomic>
+#include <bit>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "headers/Slab.h"
+
+using namespace std;
+
+namespace N::slab {
+namespace {
+    constexpr align_val_t slab_alignment {64}; // also the alignment of the oversize blocks (check Slab.h)
+    constexpr int cache_max = 64;  // free blocks a thread keeps per class
+    constexpr int batch = 32;      // blocks moved between a thread cache and the shared free list at a time
+
+    struct SizeClass {
+        size_t block;
+        size_t slab;
+        Category category;
+    };
+
+    // the small classes first, then the medium ones; class_of maps a request onto this table
+    constexpr SizeClass classes[] {
+            {64, 64 << 10, Category::small}, {128, 64 << 10, Category::small}, {256, 64 << 10, Category::small},
+            {512, 64 << 10, Category::small}, {1024, 64 << 10, Category::small},
+            {2 << 10, 1 << 20, Category::medium}, {4 << 10, 1 << 20, Category::medium}, {8 << 10, 1 << 20, Category::medium},
+            {16 << 10, 1 << 20, Category::medium}, {32 << 10, 1 << 20, Category::medium}, {64 << 10, 1 << 20, Category::medium},
+    };
+    constexpr int class_count = sizeof(classes) / sizeof(classes[0]);
+    constexpr int medium_first = 5;
+
+    // -1: not served by a slab (large category, or too big for the blocks of its category)
+    inline int class_of(size_t bytes, Category c) noexcept {
+        size_t rounded = bit_ceil(bytes < 64 ? size_t {64} : bytes);
+        int idx = countr_zero(rounded) - 6; // 64 bytes is class 0
+        switch (c) {
+            case Category::small:
+                return idx < medium_first ? idx : -1;
+            case Category::medium:
+                // a medium vector smaller than 2 KiB still comes from the medium slabs: the category is what routes it
+                idx = idx < medium_first ? medium_first : idx;
+                return idx < class_count ? idx : -1;
+            case Category::large:
+                return -1;
+        }
+        return -1;
+    }
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct Counts {
+        long allocations = 0;
+        long cache_hits = 0;
+        long refills = 0;
+        long oversize = 0;
+        long live_bytes = 0; // the change since the last flush (can be negative)
+    };
+
+    struct Totals {
+        atomic<long> allocations {0};
+        atomic<long> cache_hits {0};
+        atomic<long> refills {0};
+        atomic<long> oversize {0};
+        atomic<long> slabs {0};
+        atomic<long> reserved_bytes {0};
+        atomic<long> live_bytes {0};
+
+        void add(Counts &c) {
+            allocations.fetch_add(c.allocations, memory_order_relaxed);
+            cache_hits.fetch_add(c.cache_hits, memory_order_relaxed);
+            refills.fetch_add(c.refills, memory_order_relaxed);
+            oversize.fetch_add(c.oversize, memory_order_relaxed);
+            live_bytes.fetch_add(c.live_bytes, memory_order_relaxed);
+            c = {};
+        }
+    };
+
+    // the shared free list of one size class
+    struct Central {
+        mutex mtx;
+        FreeBlock *head = nullptr;
+        vector<void *> slab_list;
+
+        // carve a new slab into blocks and put them on the free list (called with mtx held)
+        void grow(const SizeClass &sc, Totals &t) {
+            char *slab = static_cast<char *>(::operator new(sc.slab, slab_alignment));
+            slab_list.push_back(slab);
+            for (size_t off = sc.slab; off >= sc.block; off -= sc.block) {
+                auto *b = reinterpret_cast<FreeBlock *>(slab + off - sc.block);
+                b->next = head;
+                head = b;
+            }
+            t.slabs.fetch_add(1, memory_order_relaxed);
+            t.reserved_bytes.fetch_add(static_cast<long>(sc.slab), memory_order_relaxed);
+        }
+    };
+
+    struct Shared {
+        Central central[class_count];
+        Totals totals[3]; // per Category
+    };
+
+    // never deleted on purpose: a static Vector destroyed at exit must still find the free lists
+    Shared &shared() {
+        static Shared &s = *new Shared;
+        return s;
+    }
+
+    int category_index(Category c) noexcept {
+        return static_cast<int>(c);
+    }
+
+    struct ThreadCache {
+        void *blocks[class_count][cache_max];
+        int count[class_count] {};
+        Counts counts[3];
+
+        void flush_counts() {
+            for (int c = 0; c != 3; c++) {
+                shared().totals[c].add(counts[c]);
+            }
+        }
+
+        // hand n blocks of a class back to the shared free list
+        void give_back(int cls, int n) {
+            Central &central = shared().central[cls];
+            scoped_lock sl {central.mtx};
+            for (int i = 0; i != n; i++) {
+                auto *b = static_cast<FreeBlock *>(blocks[cls][--count[cls]]);
+                b->next = central.head;
+                central.head = b;
+            }
+        }
+
+        ThreadCache();
+
+        ~ThreadCache();
+    };
+
+    // a Vector can be freed after its thread's cache was destroyed (a thread_local Vector, or a static one freed by main
+    // at exit): the state says so and those go straight to the shared lists. An enum is trivially destructible so the
+    // state itself is never destroyed
+    enum class CacheState : unsigned char {
+        unborn, alive, dead
+    };
+    thread_local CacheState cache_state = CacheState::unborn;
+    // the fast path only reads this pointer: a plain thread_local (no init guard) that is set once the cache exists
+    thread_local ThreadCache *current = nullptr;
+
+    ThreadCache::ThreadCache() {
+        cache_state = CacheState::alive;
+        current = this;
+    }
+
+    ThreadCache::~ThreadCache() {
+        cache_state = CacheState::dead;
+        current = nullptr;
+        for (int cls = 0; cls != class_count; cls++) {
+            give_back(cls, count[cls]);
+        }
+        flush_counts();
+    }
+
+    ThreadCache *make_cache() {
+        if (cache_state == CacheState::dead) {
+            return nullptr;
+        }
+        thread_local ThreadCache tc;
+        return &tc;
+    }
+
+    // nullptr once the thread's cache is gone
+    inline ThreadCache *cache() {
+        ThreadCache *tc = current;
+        return tc ? tc : make_cache();
+    }
+
+    // the paths without a thread cache: a block straight from (or to) the shared list, counted in the totals directly
+    void *take_shared(int cls) {
+        const SizeClass &sc = classes[cls];
+        Shared &s = shared();
+        Central &central = s.central[cls];
+        scoped_lock sl {central.mtx};
+        if (!central.head) {
+            central.grow(sc, s.totals[category_index(sc.category)]);
+        }
+        FreeBlock *b = central.head;
+        central.head = b->next;
+        return b;
+    }
+
+    void give_shared(int cls, void *p) {
+        Central &central = shared().central[cls];
+        scoped_lock sl {central.mtx};
+        auto *b = static_cast<FreeBlock *>(p);
+        b->next = central.head;
+        central.head = b;
+    }
+
+    // the slow path: take a batch from the shared list (growing it by a slab if it is empty). Returns one block and
+    // leaves the rest in the thread cache
+    void *refill(ThreadCache &tc, int cls) {
+        const SizeClass &sc = classes[cls];
+        Shared &s = shared();
+        Central &central = s.central[cls];
+        Counts &counts = tc.counts[category_index(sc.category)];
+        counts.refills++;
+        scoped_lock sl {central.mtx};
+        if (!central.head) {
+            central.grow(sc, s.totals[category_index(sc.category)]);
+        }
+        FreeBlock *first = central.head;
+        central.head = first->next;
+        for (int i = 1; i != batch && central.head; i++) {
+            tc.blocks[cls][tc.count[cls]++] = central.head;
+            central.head = central.head->next;
+        }
+        tc.flush_counts(); // a slow path anyway: a good time to publish the counts
+        return first;
+    }
+}
+
+void *allocate(size_t bytes, Category c) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    int cls = class_of(bytes, c);
+    ThreadCache *tc = cache();
+    if (!tc) {
+        Totals &t = shared().totals[category_index(c)];
+        t.allocations.fetch_add(1, memory_order_relaxed);
+        if (cls < 0) {
+            t.oversize.fetch_add(1, memory_order_relaxed);
+            return ::operator new(bytes, slab_alignment);
+        }
+        t.live_bytes.fetch_add(static_cast<long>(bytes), memory_order_relaxed);
+        return take_shared(cls);
+    }
+    Counts &counts = tc->counts[category_index(c)];
+    if (cls < 0) {
+        void *p = ::operator new(bytes, slab_alignment); // throws bad_alloc like new double[] did
+        counts.allocations++;
+        counts.oversize++;
+        return p;
+    }
+    void *p;
+    if (tc->count[cls] > 0) {
+        p = tc->blocks[cls][--tc->count[cls]];
+        counts.cache_hits++;
+    } else {
+        p = refill(*tc, cls);
+    }
+    counts.allocations++;
+    counts.live_bytes += static_cast<long>(bytes);
+    return p;
+}
+
+void deallocate(void *p, size_t bytes, Category c) noexcept {
+    if (!p) {
+        return;
+    }
+    int cls = class_of(bytes, c);
+    if (cls < 0) {
+        ::operator delete(p, slab_alignment);
+        return;
+    }
+    ThreadCache *tc = cache();
+    if (!tc) {
+        give_shared(cls, p);
+        shared().totals[category_index(c)].live_bytes.fetch_sub(static_cast<long>(bytes), memory_order_relaxed);
+        return;
+    }
+    tc->counts[category_index(c)].live_bytes -= static_cast<long>(bytes);
+    if (tc->count[cls] == cache_max) {
+        tc->give_back(cls, batch); // keep the other half: the next allocations will want them
+        tc->flush_counts();        // the lock was taken anyway: a good time to publish the counts
+    }
+    tc->blocks[cls][tc->count[cls]++] = p;
+}
+
+Stats stats(Category c) {
+    if (ThreadCache *tc = cache()) {
+        tc->flush_counts();
+    }
+    const Totals &t = shared().totals[category_index(c)];
+    Stats st;
+    st.allocations = t.allocations.load(memory_order_relaxed);
+    st.cache_hits = t.cache_hits.load(memory_order_relaxed);
+    st.refills = t.refills.load(memory_order_relaxed);
+    st.oversize = t.oversize.load(memory_order_relaxed);
+    st.slabs = t.slabs.load(memory_order_relaxed);
+    st.reserved_bytes = t.reserved_bytes.load(memory_order_relaxed);
+    st.live_bytes = t.live_bytes.load(memory_order_relaxed);
+    return st;
+}
+
+void report(ostream &os) {
+    streamsize precision = os.precision();
+    os << "slab report:" << endl;
+    os << setw(8) << "category" << setw(12) << "allocs" << setw(10) << "hit%" << setw(10) << "refills" << setw(10)
+       << "oversize" << setw(8) << "slabs" << setw(12) << "reserved" << setw(12) << "live" << setw(8) << "frag%" << endl;
+    const char *names[] {"small", "medium", "large"};
+    for (Category c : {Category::small, Category::medium, Category::large}) {
+        Stats st = stats(c);
+        os << setw(8) << names[category_index(c)] << setw(12) << st.allocations << setw(10) << fixed << setprecision(1)
+           << st.hit_rate() * 100 << setw(10) << st.refills << setw(10) << st.oversize << setw(8) << st.slabs << setw(12)
+           << st.reserved_bytes << setw(12) << st.live_bytes << setw(8) << st.fragmentation() * 100 << defaultfloat << endl;
+    }
+    os.precision(precision);
+}
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "headers/SparseVector.h"
+
+using namespace std;
+
+namespace N {
+namespace {
+    // below this ratio between the two lengths the merge walk wins (its branches are cheap and it streams both lists)
+    constexpr size_t gallop_ratio = 16;
+
+    void check_dimension(int a, int b) {
+        if (a != b) {
+            throw length_error("vector dimensions differ: " + to_string(a) + " and " + to_string(b));
+        }
+    }
+
+    // the first position at or after from in [from, last) whose index is >= key: doubling steps first, then a binary
+    // search in the last step
+    const int *gallop(const int *from, const int *last, int key) {
+        size_t step = 1;
+        const int *lo = from;
+        while (lo + step < last && lo[step] < key) {
+            lo += step;
+            step *= 2;
+        }
+        return lower_bound(lo, min(lo + step + 1, last), key);
+    }
+}
+
+SparseVector::SparseVector(int n): dimension {n} {
+    if (n < 0) {
+        throw length_error("negative vector dimension: " + to_string(n));
+    }
+}
+
+SparseVector::SparseVector(int n, initializer_list<pair<int, double>> entries): SparseVector(n) {
+    vector<pair<int, double>> sorted(entries);
+    sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    // on the sorted entries, not on idx: a zero is never stored, so {3, 0.0} then {3, 2.0} would get thru (and which
+    // one came first would be up to sort)
+    auto same_index = [](const auto &a, const auto &b) { return a.first == b.first; };
+    auto twice = adjacent_find(sorted.begin(), sorted.end(), same_index);
+    if (twice != sorted.end()) {
+        throw invalid_argument("index " + to_string(twice->first) + " given twice");
+    }
+    reserve(static_cast<int>(sorted.size()));
+    for (const auto &[i, v] : sorted) {
+        if (i < 0 || i >= dimension) {
+            throw out_of_range("index " + to_string(i) + " outside a vector of dimension " + to_string(dimension));
+        }
+        if (v != 0) {
+            idx.push_back(i);
+            val.push_back(v);
+        }
+    }
+}
+
+SparseVector::SparseVector(const Vector &dense): SparseVector(dense.get_size()) {
+    const double *d = dense.data();
+    for (int i = 0; i != dimension; i++) {
+        if (d[i] != 0) {
+            idx.push_back(i);
+            val.push_back(d[i]);
+        }
+    }
+}
+
+double SparseVector::operator[](int i) const {
+    if (i < 0 || i >= dimension) {
+        throw out_of_range("index " + to_string(i) + " outside a vector of dimension " + to_string(dimension));
+    }
+    auto it = lower_bound(idx.begin(), idx.end(), i);
+    return it != idx.end() && *it == i ? val[it - idx.begin()] : 0.0;
+}
+
+void SparseVector::set(int i, double v) {
+    if (i < 0 || i >= dimension) {
+        throw out_of_range("index " + to_string(i) + " outside a vector of dimension " + to_string(dimension));
+    }
+    if ((idx.empty() || idx.back() < i) && v != 0) { // the common case when filling in order
+        idx.push_back(i);
+        val.push_back(v);
+        return;
+    }
+    auto it = lower_bound(idx.begin(), idx.end(), i);
+    auto pos = it - idx.begin();
+    if (it != idx.end() && *it == i) {
+        if (v != 0) {
+            val[pos] = v;
+        } else {
+            idx.erase(it);
+            val.erase(val.begin() + pos);
+        }
+    } else if (v != 0) {
+        idx.insert(it, i);
+        val.insert(val.begin() + pos, v);
+    }
+}
+
+Vector SparseVector::to_dense() const {
+    Vector d(dimension, category_for(dimension));
+    fill_n(d.data(), dimension, 0.0);
+    for (size_t k = 0; k != idx.size(); k++) {
+        d.data()[idx[k]] = val[k];
+    }
+    return d;
+}
+
+// a gather: the dense loads are independent so the cpu keeps several cache misses in flight; two accumulators so the adds
+// do not wait on each other
+double dot(const SparseVector &x, const double *y) {
+    const int *i = x.indices();
+    const double *v = x.values();
+    const int n = x.nonzeros();
+    double s0 = 0, s1 = 0;
+    int k = 0;
+    for (; k + 1 < n; k += 2) {
+        s0 += v[k] * y[i[k]];
+        s1 += v[k + 1] * y[i[k + 1]];
+    }
+    if (k < n) {
+        s0 += v[k] * y[i[k]];
+    }
+    return s0 + s1;
+}
+
+double dot(const SparseVector &x, const Vector &y) {
+    check_dimension(x.get_size(), y.get_size());
+    return dot(x, y.data());
+}
+
+double dot(const SparseVector &a, const SparseVector &b) {
+    check_dimension(a.get_size(), b.get_size());
+    const SparseVector &shorter = a.nonzeros() <= b.nonzeros() ? a : b;
+    const SparseVector &longer = &shorter == &a ? b : a;
+    const int *si = shorter.indices(), *se = si + shorter.nonzeros();
+    const int *li = longer.indices(), *le = li + longer.nonzeros();
+    const double *sv = shorter.values(), *lv = longer.values();
+    double s = 0;
+    if (static_cast<size_t>(longer.nonzeros()) >= gallop_ratio * shorter.nonzeros()) {
+        const int *at = li;
+        for (const int *p = si; p != se && at != le; p++) {
+            at = gallop(at, le, *p);
+            if (at != le && *at == *p) {
+                s += sv[p - si] * lv[at - li];
+            }
+        }
+        return s;
+    }
+    const int *p = si, *q = li;
+    while (p != se && q != le) {
+        if (*p == *q) {
+            s += sv[p - si] * lv[q - li];
+            p++;
+            q++;
+        } else if (*p < *q) {
+            p++;
+        } else {
+            q++;
+        }
+    }
+    return s;
+}
+
+// a scatter: the stores go to distinct indices so nothing depends on anything else
+void axpy(double alpha, const SparseVector &x, double *y) {
+    const int *i = x.indices();
+    const double *v = x.values();
+    for (int k = 0; k != x.nonzeros(); k++) {
+        y[i[k]] += alpha * v[k];
+    }
+}
+
+void axpy(double alpha, const SparseVector &x, Vector &y) {
+    check_dimension(x.get_size(), y.get_size());
+    axpy(alpha, x, y.data());
+}
+
+SparseVector merge(const SparseVector &a, const SparseVector &b, double alpha, double beta) {
+    check_dimension(a.get_size(), b.get_size());
+    SparseVector out(a.get_size());
+    out.reserve(a.nonzeros() + b.nonzeros());
+    const int *ai = a.indices(), *ae = ai + a.nonzeros(), *bi = b.indices(), *be = bi + b.nonzeros();
+    const double *av = a.values(), *bv = b.values();
+    // every set() appends at the end (the indices come out in order) and drops the zeroes
+    while (ai != ae || bi != be) {
+        if (bi == be || (ai != ae && *ai < *bi)) {
+            out.set(*ai++, alpha * *av++);
+        } else if (ai == ae || *bi < *ai) {
+            out.set(*bi++, beta * *bv++);
+        } else {
+            out.set(*ai, alpha * *av++ + beta * *bv++);
+            ai++;
+            bi++;
+        }
+    }
+    return out;
+}
+}
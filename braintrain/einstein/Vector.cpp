@@ -1,9 +1,24 @@
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include "headers/Vector.h"
+#include "../common/headers/Lifecycle.h"
+#include "headers/Slab.h"
 
 using namespace std;
 using namespace N;
 
+namespace {
+    // the buffers come from the slab pools of the vector's category (check Slab.h) instead of new double[]
+    double *allocate(int len, Category c) {
+        return static_cast<double *>(slab::allocate(len * sizeof(double), c));
+    }
+
+    void deallocate(double *items, int len, Category c) noexcept {
+        slab::deallocate(items, len * sizeof(double), c);
+    }
+}
+
 Vector::Vector(int _len): Vector(_len, Category::small) {};
 
 // note that there are two syntactic styles of constructors: this one and the one below
@@ -12,13 +27,54 @@ Vector::Vector(int _len, Category _category) {
         throw length_error("negative vector length: " + to_string(_len));
     }
     length = _len;
-    items = new double[_len];
+    items = allocate(_len, _category);
     category = _category;
+    lifecycle::constructed<Vector>(_len * sizeof(double));
 }
 
 // you gotta love this static-cast crap: arrays subscripts are unsigned int so they need the case to int here
-Vector::Vector(initializer_list<double> init_list): length {static_cast<int>(init_list.size())}, items { new double [init_list.size()]} {
+Vector::Vector(initializer_list<double> init_list): length {static_cast<int>(init_list.size())}, items {allocate(static_cast<int>(init_list.size()), Category::small)}, category {Category::small} {
     copy(init_list.begin(), init_list.end(), items);
+    lifecycle::constructed<Vector>(length * sizeof(double));
+}
+
+Vector::Vector(const Vector &v): length {v.length}, items {allocate(v.length, v.category)}, category {v.category} {
+    copy(v.items, v.items + v.length, items);
+    lifecycle::copied<Vector>(length * sizeof(double));
+}
+
+Vector::Vector(Vector &&v) noexcept: length {v.length}, items {v.items}, category {v.category} {
+    lifecycle::moved<Vector>();
+    v.length = 0;
+    v.items = nullptr;
+}
+
+Vector &Vector::operator=(const Vector &v) {
+    if (&v == this) {
+        return *this;
+    }
+    lifecycle::copy_assigned<Vector>(v.length * sizeof(double));
+    double *fresh = allocate(v.length, v.category);
+    copy(v.items, v.items + v.length, fresh);
+    deallocate(items, length, category);
+    items = fresh;
+    length = v.length;
+    category = v.category;
+    return *this;
+}
+
+Vector &Vector::operator=(Vector &&v) noexcept {
+    if (&v == this) {
+        return *this;
+    }
+    lifecycle::move_assigned<Vector>();
+    deallocate(items, length, category);
+    items = v.items;
+    length = v.length;
+    category = v.category;
+    v.items = nullptr;
+    v.length = 0;
+    return *this;
 }
 
 int Vector::get_size() const {
@@ -32,12 +88,20 @@ double& Vector::operator[](int index) {
     return items[index];
 }
 
-const Category Vector::get_category() noexcept {
+const double *Vector::data() const noexcept {
+    return items;
+}
+
+double *Vector::data() noexcept {
+    return items;
+}
+
+Category Vector::get_category() noexcept {
     return category;
 }
 
 // if a func creates a Vector and the func executes and goes out of scope this destructor is called to free heap memory
 Vector::~Vector() {
-    cout << "destructor is called" << endl;
-    delete [] items; // plain delete deletes a single object, delete[] deletes the array
+    lifecycle::destroyed<Vector>();
+    deallocate(items, length, category); // was delete [] items (plain delete deletes a single object, delete[] deletes the array)
 }
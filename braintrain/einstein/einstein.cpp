@@ -2,7 +2,13 @@
 #include <vector>
 #include <map>
 #include<complex>
+#include <chrono>
+#include <thread>
 #include "headers/Vector.h"
+#include "headers/Reduce.h"
+#include "headers/Slab.h"
+#include "headers/Matrix.h"
+#include "headers/SparseVector.h"
 
 //import Vector2; -- does not work
 
@@ -42,7 +48,7 @@ double sum3(Vector v) {
     for (int i = 0; i != v.get_size(); i++) {
         s += v[i];
     }
-    v[0] = 200; // changes the value in the vector declared in the calling code
+    v[0] = 200; // only changes the copy now that Vector has a (deep) copy-cntr - the caller still sees 100
     return s;
 }
 
@@ -146,9 +152,10 @@ void work_with_classes() {
     // again to free the (already freed) double array on the heap. This gives this out of context exception that reminds me
     // of my C days at school:
     // cpp2(7982,0x11b6e6dc0) malloc: *** error for object 0x7fe24fc05850: pointer being freed was not allocated
-
-//    cout << "pbn::vec.size = " << vec.get_size() <<  " - sum = " << sum3(vec) << endl;
-//    cout << "pbn::v[0] = " << vec[0] << endl;
+    // Fixed since by giving Vector a copy-cntr that copies the array (rule of five): the by-value param gets its own
+    // copy. It works but it copies the whole array just to sum it, so pass by (const) ref anyway.
+    cout << "pbn::vec.size = " << vec.get_size() <<  " - sum = " << sum3(vec) << endl;
+    cout << "pbn::v[0] = " << vec[0] << endl;
 }
 
 // the craziness here is avoided by making the Vector(int) cntr explict (no implicit conversion from int to vector)
@@ -169,6 +176,222 @@ void crazy_constructor_conversion() {
     cout << v2.get_size() << endl;
 }
 
+// time a reduction over a big vector: the bounds-checked loop of sum2, the raw-pointer loop of sum(Vector01) and the
+// simd reductions for every instruction set this cpu supports
+void reduction_benchmark() {
+    cout << "reduction_benchmark" << endl;
+    using namespace chrono;
+    const int len = 8'000'000;
+    const int rounds = 20;
+    Vector vec(len);
+    for (int i = 0; i != len; i++) {
+        vec[i] = (i % 100) * 0.5;
+    }
+
+    auto time_it = [&](const string &name, auto reduce) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            s += reduce();
+        }
+        auto t2 = high_resolution_clock::now();
+        double secs = duration<double>(t2 - t1).count();
+        double gbs = static_cast<double>(len) * sizeof(double) * rounds / secs / 1e9;
+        cout << name << ": " << secs * 1000 / rounds << " ms/round, " << gbs << " GB/s (checksum " << s / rounds << ")" << endl;
+    };
+
+    time_it("checked-operator[]", [&] {
+        double s = 0;
+        for (int i = 0; i != vec.get_size(); i++) {
+            s += vec[i];
+        }
+        return s;
+    });
+    Vector01 raw {len, vec.data()}; // borrow the buffer; Vector01 has no destructor so nothing is freed twice
+    time_it("raw-pointer-loop", [&] { return sum(raw); });
+
+    simd::Isa best = simd::active_isa();
+    for (simd::Isa isa : {simd::Isa::scalar, simd::Isa::sse2, simd::Isa::avx2, simd::Isa::avx512}) {
+        if (isa > best) {
+            break;
+        }
+        simd::use_isa(isa);
+        time_it(string("simd::sum-") + simd::isa_name(isa), [&] { return simd::sum(vec); });
+    }
+    simd::use_isa(best);
+    cout << "dot = " << simd::dot(vec, vec) << ", norm = " << simd::norm(vec) << ", min = " << simd::min(vec)
+         << ", max = " << simd::max(vec) << endl;
+}
+
+// a bimodal profile: lots of short vectors (16 doubles, small) and some mid sized ones (1000 doubles, medium). The last 64
+// stay alive (a ring) like the in-flight buffers of a server. new double[] goes to malloc for every one; the Vector buffers
+// come from the slab pools of their category (Slab.h) and are mostly a pop off the thread's cache
+void slab_vectors() {
+    cout << "slab_vectors" << endl;
+    using namespace chrono;
+    const int rounds = 1'000'000;
+    const int ring_size = 64;
+    auto len_of = [](int r) { return r % 8 == 0 ? 1000 : 16; };
+    auto category_of = [](int r) { return r % 8 == 0 ? Category::medium : Category::small; };
+
+    auto time_it = [&](const string &name, auto work) {
+        auto t1 = high_resolution_clock::now();
+        double s = work();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, nano>(t2 - t1).count() / rounds << " ns/vector (checksum " << s << ")" << endl;
+    };
+
+    time_it("new double[]", [&] {
+        double *ring[ring_size] {};
+        double s = 0;
+        for (int r = 0; r != rounds; r++) {
+            double *&slot = ring[r % ring_size];
+            delete [] slot;
+            slot = new double[len_of(r)];
+            slot[0] = r;
+            s += slot[0];
+        }
+        for (double *p : ring) {
+            delete [] p;
+        }
+        return s;
+    });
+
+    vector<Vector> ring;
+    time_it("slab Vector", [&] {
+        double s = 0;
+        for (int r = 0; r != rounds; r++) {
+            Vector v(len_of(r), category_of(r));
+            v[0] = r;
+            s += v[0];
+            if (r < ring_size) {
+                ring.push_back(std::move(v));
+            } else {
+                ring[r % ring_size] = std::move(v); // frees the one it replaces
+            }
+        }
+        return s;
+    });
+
+    // the same from 4 threads at once: each one works out of its own cache and only meets the others on a refill
+    time_it("slab Vector x4 threads", [&] {
+        vector<thread> workers;
+        vector<double> sums(4);
+        for (int t = 0; t != 4; t++) {
+            workers.emplace_back([&, t] {
+                vector<Vector> own;
+                for (int r = 0; r != rounds / 4; r++) {
+                    Vector v(len_of(r), category_of(r));
+                    v[0] = r;
+                    sums[t] += v[0];
+                    if (r < ring_size) {
+                        own.push_back(std::move(v));
+                    } else {
+                        own[r % ring_size] = std::move(v);
+                    }
+                }
+            });
+        }
+        for (thread &w : workers) {
+            w.join();
+        }
+        return sums[0] + sums[1] + sums[2] + sums[3];
+    });
+
+    Vector big(100'000, Category::large); // large vectors are not pooled
+    Vector too_big(100'000, Category::small); // too big for the small blocks: oversize
+    slab::report(cout); // the ring is still alive: live bytes and fragmentation are for its 64 vectors
+}
+
+// GFLOP/s of c = a * b (2*n^3 flops) for the triple loop and the blocked gemm on 1 thread and on every core. The naive loop
+// walks b down a column (a cache miss per element once b outgrows the cache); gemm packs b so the kernel reads it in order
+void matrix_benchmark() {
+    cout << "matrix_benchmark" << endl;
+    using namespace chrono;
+    for (int n : {256, 512}) {
+        Matrix a(n, n), b(n, n);
+        for (int i = 0; i != n; i++) {
+            for (int j = 0; j != n; j++) {
+                a(i, j) = (i * 7 + j * 3) % 11 * 0.25;
+                b(i, j) = (i * 5 + j) % 13 * 0.5 - 3;
+            }
+        }
+        Matrix reference(n, n);
+        auto time_it = [&](const string &name, auto multiply) {
+            Matrix c(n, n);
+            auto t1 = high_resolution_clock::now();
+            multiply(c);
+            auto t2 = high_resolution_clock::now();
+            double secs = duration<double>(t2 - t1).count();
+            double diff = 0;
+            for (int i = 0; i != n; i++) {
+                for (int j = 0; j != n; j++) {
+                    diff = max(diff, abs(c(i, j) - reference(i, j)));
+                }
+            }
+            cout << n << "x" << n << " " << name << ": " << secs * 1000 << " ms, " << 2.0 * n * n * n / secs / 1e9
+                 << " GFLOP/s (max diff " << diff << ")" << endl;
+        };
+        gemm_naive(a, b, reference);
+        time_it("naive", [&](Matrix &c) { gemm_naive(a, b, c); });
+        time_it("gemm 1 thread", [&](Matrix &c) { gemm(a, b, c, 1, 0, 1); });
+        time_it("gemm all threads", [&](Matrix &c) { gemm(a, b, c); });
+
+        Vector x(n), y(n);
+        for (int i = 0; i != n; i++) {
+            x[i] = i % 7;
+        }
+        auto t1 = high_resolution_clock::now();
+        gemv(a, x.data(), y.data());
+        Matrix t = transpose(a);
+        auto t2 = high_resolution_clock::now();
+        cout << n << "x" << n << " gemv + transpose: " << duration<double, micro>(t2 - t1).count() << " us (y[1] = "
+             << y[1] << ", t(1, 0) == a(0, 1): " << boolalpha << (t(1, 0) == a(0, 1)) << ")" << endl;
+    }
+    Matrix m {{1, 2}, {3, 4}};
+    Matrix p = m * Matrix::identity(2);
+    cout << "m * I = {{" << p(0, 0) << ", " << p(0, 1) << "}, {" << p(1, 0) << ", " << p(1, 1) << "}}" << endl;
+}
+
+// feature vectors of a million dims with 0.5% set: the dense dot reads 16 MB, the sparse-dense one 60 KB plus a cache line
+// per non-zero, and the sparse-sparse one only the two index lists (galloping when one list is much shorter)
+void sparse_vectors() {
+    cout << "sparse_vectors" << endl;
+    using namespace chrono;
+    const int dims = 1'000'000;
+    const int rounds = 20;
+    SparseVector features(dims), query(dims);
+    for (int i = 0; i < dims; i += 200) {
+        features.set(i, (i % 7) + 1.0);
+    }
+    for (int i = 0; i < dims; i += 20'000) { // 50 terms
+        query.set(i, 0.5);
+    }
+    Vector dense = features.to_dense();
+    Vector weights = dense; // a dense model vector to dot against
+    cout << "non-zeros: " << features.nonzeros() << " of " << dims << ", sparse bytes: "
+         << features.nonzeros() * (sizeof(int) + sizeof(double)) << ", dense bytes: " << dims * sizeof(double) << endl;
+
+    auto time_it = [&](const string &name, auto work) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            s += work();
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, micro>(t2 - t1).count() / rounds << " us (checksum " << s / rounds << ")" << endl;
+    };
+    time_it("dense dot", [&] { return simd::dot(dense, weights); });
+    time_it("sparse-dense dot", [&] { return dot(features, weights); });
+    time_it("sparse-sparse dot (merge walk)", [&] { return dot(features, features); });
+    time_it("sparse-sparse dot (galloping)", [&] { return dot(query, features); });
+
+    axpy(-1, features, weights); // weights was a copy of features: all zeroes now
+    SparseVector both = merge(features, query, 1, 2);
+    cout << "after axpy: " << simd::norm(weights) << ", merge non-zeros: " << both.nonzeros() << ", merged[20000] = "
+         << both[20'000] << endl;
+}
+
 int main() {
     vector<int> v1 = {1, 2, 3};
     vector<int> v2 = {7, 5, 9};
@@ -185,5 +408,9 @@ int main() {
     structured_binding_classes();
     init_container_with_init_list();
     crazy_constructor_conversion();
+    reduction_benchmark();
+    slab_vectors();
+    matrix_benchmark();
+    sparse_vectors();
     return 0;
 }
@@ -0,0 +1,62 @@
+#ifndef BRAINTRAIN_MATRIX_H
+#define BRAINTRAIN_MATRIX_H
+
+#include <initializer_list>
+#include "Vector.h"
+
+namespace N {
+    // a dense row-major matrix: element (r, c) is at r * cols + c of one N::Vector, so the storage is contiguous and
+    // 64-byte aligned (check Slab.h) and the Vector's category is picked by its size
+    class Matrix {
+    private:
+        int rows;
+        int cols;
+        Vector storage;
+    public:
+        Matrix(int, int); // rows x cols of zeroes
+
+        Matrix(initializer_list<initializer_list<double>>); // row by row; every row must have the same length
+
+        static Matrix identity(int);
+
+        [[nodiscard]] int get_rows() const noexcept { return rows; }
+
+        [[nodiscard]] int get_cols() const noexcept { return cols; }
+
+        // unchecked, for the inner loops
+        double &operator()(int r, int c) noexcept { return storage.data()[static_cast<long>(r) * cols + c]; }
+
+        double operator()(int r, int c) const noexcept { return storage.data()[static_cast<long>(r) * cols + c]; }
+
+        double &at(int, int); // throws out_of_range
+
+        [[nodiscard]] double *data() noexcept { return storage.data(); }
+
+        [[nodiscard]] const double *data() const noexcept { return storage.data(); }
+
+        [[nodiscard]] double *row(int r) noexcept { return data() + static_cast<long>(r) * cols; }
+
+        [[nodiscard]] const double *row(int r) const noexcept { return data() + static_cast<long>(r) * cols; }
+    };
+
+    // the kernels split the work across threads (threads = 0: one per core) when the matrices are big enough to pay for
+    // starting them. gemm and the operators throw length_error when the shapes do not fit
+
+    // c = alpha * a * b + beta * c. Cache blocked (b is copied panel by panel into the order the micro-kernel reads it, a
+    // block by block) and register tiled (a 4 x 8 tile of c stays in registers for the whole inner loop)
+    void gemm(const Matrix &a, const Matrix &b, Matrix &c, double alpha = 1, double beta = 0, int threads = 0);
+
+    // the textbook triple loop, for checking and benchmarking gemm against
+    void gemm_naive(const Matrix &a, const Matrix &b, Matrix &c);
+
+    // y = alpha * a * x + beta * y (x has a.get_cols() doubles, y has a.get_rows())
+    void gemv(const Matrix &a, const double *x, double *y, double alpha = 1, double beta = 0, int threads = 0);
+
+    Matrix transpose(const Matrix &, int threads = 0);
+
+    Matrix operator*(const Matrix &, const Matrix &);
+
+    Vector operator*(const Matrix &, const Vector &);
+}
+
+#endif //BRAINTRAIN_MATRIX_H
@@ -0,0 +1,43 @@
+#ifndef BRAINTRAIN_REDUCE_H
+#define BRAINTRAIN_REDUCE_H
+
+#include "Vector.h"
+#include "../../common/headers/Dispatch.h"
+
+// reductions over the raw Vector buffer. Each one has a scalar, SSE2, AVX2 and AVX-512 kernel; the widest one the cpu
+// supports is picked (common/headers/Dispatch.h) the first time any of them is called
+namespace N::simd {
+    using Isa = cpu::Isa;
+
+    // the instruction set the reductions currently dispatch to
+    Isa active_isa() noexcept;
+
+    // force a narrower instruction set (handy for benchmarking); asking for more than the cpu supports is clamped down.
+    // returns the isa that is actually in use afterwards. Safe while other threads are reducing
+    Isa use_isa(Isa) noexcept;
+
+    const char *isa_name(Isa) noexcept;
+
+    // the pointer versions work on any double buffer (Vector01 in einstein.cpp for example)
+    double sum(const double *, int);
+
+    double dot(const double *, const double *, int);
+
+    double min(const double *, int);
+
+    double max(const double *, int);
+
+    double norm(const double *, int); // euclidean (l2) norm
+
+    double sum(const Vector &);
+
+    double dot(const Vector &, const Vector &); // throws length_error if the lengths differ
+
+    double min(const Vector &); // min/max throw length_error on an empty vector (there is nothing sensible to return)
+
+    double max(const Vector &);
+
+    double norm(const Vector &);
+}
+
+#endif //BRAINTRAIN_REDUCE_H
@@ -0,0 +1,45 @@
+#ifndef BRAINTRAIN_SLAB_H
+#define BRAINTRAIN_SLAB_H
+
+#include <cstddef>
+#include <ostream>
+#include "Vector.h"
+
+// where the Vector buffers come from. The Category of a vector picks the pool:
+//   small:  slabs of 64 KiB cut into blocks of 64, 128, 256, 512 or 1024 bytes (up to 128 doubles)
+//   medium: slabs of 1 MiB cut into blocks of 2, 4, 8, 16, 32 or 64 KiB (up to 8192 doubles)
+//   large:  straight to operator new - big buffers are rare and malloc hands them to mmap anyway
+// a request bigger than the largest block of its category also goes to operator new (counted as 'oversize').
+// Every block is 64-byte aligned (a cache line, and an avx-512 register): the blocks are power of 2 sizes cut from
+// aligned slabs and the rest are allocated with that alignment, so a Vector buffer never straddles lines needlessly.
+// Every thread keeps a small stack of free blocks per size class and only takes the lock of the class to move a batch
+// of blocks in or out, so most allocations are a pop off a thread_local array. Slabs are never given back to the system:
+// a freed block goes back on the free list of its class.
+namespace N::slab {
+    void *allocate(size_t bytes, Category);
+
+    // bytes and category must be the ones the block was allocated with (Vector has both at hand)
+    void deallocate(void *, size_t bytes, Category) noexcept;
+
+    struct Stats {
+        long allocations = 0;
+        long cache_hits = 0;   // served from the thread's cache without taking a lock
+        long refills = 0;      // times a thread cache went to the shared free list for a batch
+        long oversize = 0;     // too big for the category's blocks (or a large vector): went to operator new
+        long slabs = 0;
+        long reserved_bytes = 0; // in slabs
+        long live_bytes = 0;     // requested by the blocks that are handed out right now (the oversize ones excluded)
+
+        [[nodiscard]] double hit_rate() const { return allocations ? static_cast<double>(cache_hits) / allocations : 0; }
+
+        // the share of the slab memory that holds no live data: rounding up to the block size + the free blocks
+        [[nodiscard]] double fragmentation() const { return reserved_bytes ? 1 - static_cast<double>(live_bytes) / reserved_bytes : 0; }
+    };
+
+    // the counts of other threads are included once they have refilled, flushed or exited; the current thread's are always
+    Stats stats(Category);
+
+    void report(std::ostream &);
+}
+
+#endif //BRAINTRAIN_SLAB_H
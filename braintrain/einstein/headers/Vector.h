@@ -20,6 +20,12 @@ namespace N {
         }
     }
 
+    // the category that fits len doubles: small up to 1 KiB, medium up to 64 KiB. In long since len * 8 overflows an int
+    inline Category category_for(int len) {
+        long bytes = len * static_cast<long>(sizeof(double));
+        return bytes <= 1024 ? Category::small : bytes <= (64 << 10) ? Category::medium : Category::large;
+    }
+
     class Vector {
 
     private:
@@ -35,6 +41,14 @@ namespace N {
 
         Vector();
 
+        Vector(const Vector &); // copy-cntr: deep copy (the implicit one copied the pointer and both copies freed it)
+
+        Vector(Vector &&) noexcept; // move-cntr
+
+        Vector &operator=(const Vector &);
+
+        Vector &operator=(Vector &&) noexcept;
+
         ~Vector();
 
         // const signifies that this func doesn't modify its object. It can be called by const and non-const objects
@@ -43,8 +57,13 @@ namespace N {
 
         double &operator[](int);
 
+        // unchecked access to the buffer for bulk algorithms (the reductions in Reduce.h) - operator[] throws on every call
+        [[nodiscard]] const double *data() const noexcept;
+
+        [[nodiscard]] double *data() noexcept;
+
         // should never throw and exception but if it does the program will terminate by calling std::terminate()
-        const Category get_category() noexcept;
+        Category get_category() noexcept;
     };
 }
 
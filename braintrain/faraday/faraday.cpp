@@ -9,15 +9,19 @@
 #include <queue>
 #include <future>
 #include <numeric>
+#include <chrono>
+#include <iomanip>
+#include <vector>
+#include "headers/Summation.h"
+#include "../common/headers/Symbol.h"
 
 using namespace std;
 
 struct School {
-    string name;
+    Symbol name;
     int capacity = 0;
 
-    // instead of passing name by ref (const &name), Clang-Tidy suggested passing by value and 'move'
-    School(string name, int capacity) : name{move(name)}, capacity{capacity} {}
+    School(string_view name, int capacity) : name{name}, capacity{capacity} {}
 
     bool operator==(const School &other) const {
         return name == other.name;
@@ -129,8 +133,10 @@ void producer_consumer(bool run) {
     cth.join();
 }
 
+// was accumulate(begin, end, 0.0) (accumulate is in std::numerics): its error grows with the length, pairwise summation's
+// only with log(length) at the same speed (check Summation.h). One thread since the callers below already split the work
 double accum(const double* begin, const double* end) {
-    return accumulate(begin, end, 0.0); // accumulate is in std::numerics
+    return summation::sum(begin, end, summation::Method::pairwise, 1);
 }
 
 // more clunky apis ahead!
@@ -171,16 +177,134 @@ void async_example() {
     cout << "async vector sum: " << f1.get() + f2.get() << endl;
 }
 
+// 10 million times 0.1: the exact answer is 1e6 but 0.1 has no exact binary representation, so the sum is off by roughly
+// n * 1e-17 (the error in 0.1 itself) - everything above that is rounding piling up
+void stable_sums() {
+    cout << "stable_sums" << endl;
+    using namespace chrono;
+    using summation::Method;
+    vector<double> vec(10'000'000, 0.1);
+
+    auto time_it = [&](const string &name, auto work) {
+        auto t1 = high_resolution_clock::now();
+        double s = work();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << setprecision(17) << s << " (error " << setprecision(3) << s - 1e6 << ") in "
+             << setprecision(6) << duration<double, milli>(t2 - t1).count() << " ms" << endl;
+        return s;
+    };
+
+    time_it("accumulate", [&] { return accumulate(vec.begin(), vec.end(), 0.0); });
+    time_it("pairwise", [&] { return summation::sum(vec, Method::pairwise, 1); });
+    time_it("kahan", [&] { return summation::sum(vec, Method::kahan, 1); });
+    double p4 = time_it("pairwise x4 threads", [&] { return summation::sum(vec, Method::pairwise, 4); });
+    double k4 = time_it("kahan x4 threads", [&] { return summation::sum(vec, Method::kahan, 4); });
+
+    // the same thread count gives the same bits every time no matter how the threads were scheduled
+    bool same = true;
+    for (int i = 0; i != 5; i++) {
+        same = same && summation::sum(vec, Method::pairwise, 4) == p4 && summation::sum(vec, Method::kahan, 4) == k4;
+    }
+    cout << "deterministic: " << same << endl;
+}
+
+// a million enrollment records that name only 2000 schools: the school name as a string in every record against an
+// interned Symbol. Four threads intern the names at the same time and must all get the same ids
+void interned_names() {
+    cout << "interned_names" << endl;
+    using namespace chrono;
+    const int records = 1'000'000;
+    const int schools = 2000;
+    struct StringRecord {
+        string school;
+        int student = 0;
+    };
+    struct SymbolRecord {
+        Symbol school;
+        int student = 0;
+    };
+    auto school_name = [](int i) { return "Brooklyn Technical High School #" + to_string(i); };
+
+    vector<vector<uint32_t>> ids(4);
+    vector<thread> threads;
+    for (int t = 0; t != 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i != schools; i++) {
+                ids[t].push_back(Symbol {school_name((i * 7 + t * 13) % schools)}.get_id());
+            }
+        });
+    }
+    for (thread &th : threads) {
+        th.join();
+    }
+    bool consistent = true;
+    for (int t = 1; t != 4; t++) {
+        for (int i = 0; i != schools; i++) { // thread t interned name k at position (k - t * 13) / 7 (mod schools)
+            int k = (i * 7 + t * 13) % schools;
+            int i0 = find(ids[0].begin(), ids[0].end(), Symbol {school_name(k)}.get_id()) - ids[0].begin();
+            consistent = consistent && i0 != schools && ids[t][i] == ids[0][i0];
+        }
+    }
+    cout << "threads agree: " << consistent << " - symbols: " << SymbolTable::global().size() << endl;
+
+    vector<StringRecord> as_strings;
+    vector<SymbolRecord> as_symbols;
+    as_strings.reserve(records);
+    as_symbols.reserve(records);
+    for (int i = 0; i != records; i++) {
+        string name = school_name(i * 37 % schools);
+        as_symbols.push_back({Symbol {name}, i});
+        as_strings.push_back({std::move(name), i});
+    }
+    // a name longer than the 15 chars that fit inside the string is a heap block per record (at least 32 bytes with malloc's
+    // header and rounding); the symbols' strings are stored once
+    size_t string_bytes = records * (sizeof(StringRecord) + 48);
+    size_t symbol_bytes = records * sizeof(SymbolRecord) + SymbolTable::global().char_count();
+    cout << "records: " << string_bytes / 1'000'000 << " MB as strings, " << symbol_bytes / 1'000'000 << " MB as symbols"
+         << endl;
+
+    auto time_it = [](const string &name, auto count) {
+        auto t1 = high_resolution_clock::now();
+        long n = count();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, milli>(t2 - t1).count() << " ms (" << n << ")" << endl;
+    };
+    const string wanted = school_name(1234);
+    const Symbol wanted_symbol {wanted};
+    time_it("string ==", [&] {
+        return count_if(as_strings.begin(), as_strings.end(), [&](const StringRecord &r) { return r.school == wanted; });
+    });
+    time_it("symbol ==", [&] {
+        return count_if(as_symbols.begin(), as_symbols.end(), [&](const SymbolRecord &r) { return r.school == wanted_symbol; });
+    });
+    time_it("string hash", [&] {
+        unordered_map<string, int> per_school;
+        for (const StringRecord &r : as_strings) {
+            per_school[r.school]++;
+        }
+        return static_cast<long>(per_school.size());
+    });
+    time_it("symbol hash", [&] {
+        unordered_map<Symbol, int> per_school;
+        for (const SymbolRecord &r : as_symbols) {
+            per_school[r.school]++;
+        }
+        return static_cast<long>(per_school.size());
+    });
+}
+
 // note that argc will always be 1 or more; name of the executable is at index 0, and first custom arg is at index 1
 int main(int argc, char* argv[]) {
     cout << "arg0: " << argv[0] <<  endl;
-    cout << "arg1: " << argv[1] << endl;
+    cout << "arg1: " << (argc > 1 ? argv[1] : "") << endl; // argv[argc] is a null pointer and cout << null is undefined
     threads_basic();
     scoped_locks();
     read_write_locks();
     producer_consumer(false);
     packaged_task_example();
     async_example();
+    stable_sums();
+    interned_names();
 
     return 0;
 }
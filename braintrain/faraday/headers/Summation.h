@@ -0,0 +1,176 @@
+#ifndef BRAINTRAIN_SUMMATION_H
+#define BRAINTRAIN_SUMMATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+// summing n numbers one after the other (accumulate) has an error that grows with n: once the running total is large every
+// small element loses its low bits. Two ways around it:
+//   pairwise: sum the halves separately and add them up (recursively) - the error grows with log(n) and it costs nothing
+//   kahan:    carry the bits lost on every add in a second 'compensation' variable - the error does not grow with n at all,
+//             for ~4 flops per element instead of 1
+// Both are vectorized: the innermost loop keeps 8 independent accumulators (lanes) the compiler maps onto simd registers.
+// That reorders the additions, so it is done by hand and not with -ffast-math (which would also 'optimize' kahan's
+// compensation away - never build this with it).
+// Large inputs are split into one chunk per thread. The chunk boundaries depend only on the length and the thread count,
+// and the partial sums are combined in a fixed order, so for a given thread count the result is the same on every run
+// (but 4 threads and 8 threads can differ in the last bits: pass an explicit thread count where that matters).
+// T needs +, - and a T{} that is zero: doubles, floats, ints and complex all work.
+namespace summation {
+    enum class Method {
+        naive, pairwise, kahan
+    };
+
+    inline constexpr int lanes = 8;
+    inline constexpr std::ptrdiff_t pairwise_block = 256; // below this the lanes do a block straight
+    inline constexpr std::ptrdiff_t min_per_thread = 1 << 15; // smaller chunks are summed in the calling thread
+
+    template<typename T>
+    T naive_sum(const T *p, std::ptrdiff_t n) {
+        T s {};
+        for (std::ptrdiff_t i = 0; i != n; i++) {
+            s += p[i];
+        }
+        return s;
+    }
+
+    // a straight block in lanes, the lanes added up pairwise at the end
+    template<typename T>
+    T lane_sum(const T *p, std::ptrdiff_t n) {
+        T acc[lanes] {};
+        std::ptrdiff_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            for (int j = 0; j != lanes; j++) {
+                acc[j] += p[i + j];
+            }
+        }
+        for (int j = 0; i != n; i++, j++) {
+            acc[j] += p[i];
+        }
+        return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    }
+
+    template<typename T>
+    T pairwise_sum(const T *p, std::ptrdiff_t n) {
+        if (n <= pairwise_block) {
+            return lane_sum(p, n);
+        }
+        std::ptrdiff_t half = n / 2 / lanes * lanes; // the left half a whole number of lanes so its loop has no tail
+        return pairwise_sum(p, half) + pairwise_sum(p + half, n - half);
+    }
+
+    // a sum and the low order bits it lost on the way
+    template<typename T>
+    struct Compensated {
+        T sum {};
+        T c {};
+
+        // kahan's step: y is x less what was lost so far, and what gets lost adding y is recovered by (t - sum) - y
+        void add(T x) {
+            T y = x - c;
+            T t = sum + y;
+            c = (t - sum) - y;
+            sum = t;
+        }
+
+        void add(const Compensated &other) {
+            add(other.sum);
+            add(-other.c);
+        }
+
+        [[nodiscard]] T value() const { return sum - c; }
+    };
+
+    template<typename T>
+    Compensated<T> kahan_partial(const T *p, std::ptrdiff_t n) {
+        // the lanes are written out as separate arrays (not an array of Compensated) so the loop is plain simd arithmetic
+        T sum[lanes] {}, c[lanes] {};
+        std::ptrdiff_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            for (int j = 0; j != lanes; j++) {
+                T y = p[i + j] - c[j];
+                T t = sum[j] + y;
+                c[j] = (t - sum[j]) - y;
+                sum[j] = t;
+            }
+        }
+        Compensated<T> total;
+        for (int j = 0; j != lanes; j++) {
+            total.add(Compensated<T> {sum[j], c[j]});
+        }
+        for (; i != n; i++) {
+            total.add(p[i]);
+        }
+        return total;
+    }
+
+    template<typename T>
+    T kahan_sum(const T *p, std::ptrdiff_t n) {
+        return kahan_partial(p, n).value();
+    }
+
+    // threads = 0 means one per core (std::thread::hardware_concurrency)
+    template<typename T>
+    T sum(const T *first, const T *last, Method method = Method::pairwise, int threads = 0) {
+        std::ptrdiff_t n = last - first;
+        if (threads <= 0) {
+            threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        // the partition is fixed by n and threads; whether the chunks actually run on other threads does not matter
+        std::vector<Compensated<T>> partials(threads);
+        auto chunk = [&](int t) {
+            const T *b = first + n * t / threads;
+            const T *e = first + n * (t + 1) / threads;
+            switch (method) {
+                case Method::naive:
+                    partials[t].sum = naive_sum(b, e - b);
+                    break;
+                case Method::pairwise:
+                    partials[t].sum = pairwise_sum(b, e - b);
+                    break;
+                case Method::kahan:
+                    partials[t] = kahan_partial(b, e - b);
+                    break;
+            }
+        };
+        if (threads == 1 || n / threads < min_per_thread) {
+            for (int t = 0; t != threads; t++) {
+                chunk(t);
+            }
+        } else {
+            std::vector<std::thread> workers;
+            for (int t = 1; t != threads; t++) {
+                workers.emplace_back(chunk, t);
+            }
+            chunk(0); // the calling thread does its share too
+            for (std::thread &w : workers) {
+                w.join();
+            }
+        }
+
+        if (method == Method::kahan) {
+            Compensated<T> total;
+            for (const Compensated<T> &p : partials) {
+                total.add(p);
+            }
+            return total.value();
+        }
+        std::vector<T> sums(threads);
+        for (int t = 0; t != threads; t++) {
+            sums[t] = partials[t].sum;
+        }
+        return method == Method::pairwise ? pairwise_sum(sums.data(), threads) : naive_sum(sums.data(), threads);
+    }
+
+    // any contiguous container: vector, array, initializer_list, TVector (its begin() is a plain pointer)...
+    template<std::ranges::contiguous_range R>
+    auto sum(const R &r, Method method = Method::pairwise, int threads = 0) {
+        auto *first = std::ranges::data(r);
+        return sum(first, first + std::ranges::size(r), method, threads);
+    }
+}
+
+#endif //BRAINTRAIN_SUMMATION_H
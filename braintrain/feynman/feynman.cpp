@@ -11,15 +11,20 @@
 #include <algorithm>
 #include <variant>
 #include <any>
+#include <iterator>
+#include <optional>
+#include <memory>
+#include "../common/headers/Symbol.h"
 
 using namespace std;
 
 struct City {
-    string name;
+    Symbol name;
     int population = 0;
 
-    // instead of passing name by ref (const &name), Clang-Tidy suggested passing by value and 'move'
-    City(string name, int population) : name{move(name)}, population{population} {}
+    // a string_view is enough: the name is copied into the symbol table once, the first time it is seen (Clang-Tidy
+    // suggested passing a string by value and 'move' when this was a string member)
+    City(string_view name, int population) : name{name}, population{population} {}
 
     bool operator==(const City &other) const {
         return name == other.name;
@@ -1,13 +1,23 @@
 #include <iostream>
 #include "headers/Complex3.h"
+#include "../common/headers/Lifecycle.h"
 
 using namespace std;
 
-Complex3::Complex3() {cout << "Complex3 - default cntr" << endl;} // rl and img use the default member initializers (check header)
+Complex3::Complex3() {lifecycle::constructed<Complex3>();} // rl and img use the default member initializers (check header)
 
-Complex3::Complex3(double rl, double img) : rl(rl), img(img) {cout << "Complex3 - (double, double) cntr" << endl;}
+Complex3::Complex3(double rl, double img) : rl(rl), img(img) {lifecycle::constructed<Complex3>();}
 
-Complex3::Complex3(Complex3& c3): rl(c3.rl), img(c3.img) {cout << "Complex3 - copy cntr: " <<  c3.rl <<endl;} // copy contr - arg always passed by reference
+Complex3::Complex3(const Complex3& c3): rl(c3.rl), img(c3.img) {lifecycle::copied<Complex3>();} // copy contr - arg always passed by reference
+
+Complex3& Complex3::operator=(const Complex3& c3) {
+    lifecycle::copy_assigned<Complex3>();
+    rl = c3.rl;
+    img = c3.img;
+    return *this;
+}
+
+Complex3::~Complex3() {lifecycle::destroyed<Complex3>();}
 
 // note where const is placed to actually be counted (seems it means different things at different locations - c++ till this point is living to its reputation of obfuscation)
 // the const specifier on the function returning the real part indicates that this function does not modify the object for which they are called
@@ -21,6 +31,14 @@ Complex3& Complex3::operator+=(Complex3 &c) { // calls copy-cntr for the value i
     img += c.imag();
     return *this;
 }
+
+// (a + bi)(c + di) = (ac - bd) + (ad + bc)i. The real part is kept in a local since the imag part still needs the old one
+Complex3& Complex3::operator*=(Complex3 c) {
+    double r = rl * c.real() - img * c.imag();
+    img = rl * c.imag() + img * c.real();
+    rl = r;
+    return *this;
+}
 // B.S. says that this could be defined elsewhere but I got compile errors about having 3 args for the binary operator
 // so defined here it does not work with c1 + c2. I am missing some more twists in this sad api.
 Complex3 operator+ (Complex3 c1, Complex3 c2) { // passed by value so we can change in the func w/o affecting caller
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include "headers/ComplexArray.h"
+#include "../common/headers/Lifecycle.h"
+#include "../common/headers/Dispatch.h"
+
+#ifdef BRAINTRAIN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    constexpr align_val_t alignment {64}; // a cache line, and the width of an avx-512 register
+
+    double *allocate(int n) {
+        if (n < 0) {
+            throw length_error("negative array length: " + to_string(n));
+        }
+        return n == 0 ? nullptr : static_cast<double *>(::operator new(n * sizeof(double), alignment));
+    }
+
+    void deallocate(double *p) noexcept {
+        if (p) {
+            ::operator delete(p, alignment);
+        }
+    }
+
+    void check_lengths(const ComplexArray &a, const ComplexArray &b) {
+        if (a.get_size() != b.get_size()) {
+            throw length_error("array lengths differ: " + to_string(a.get_size()) + " and " + to_string(b.get_size()));
+        }
+    }
+
+    // every kernel takes the planes separately: (ar, ai) op (br, bi) -> (or, oi)
+    struct Kernels {
+        void (*add)(const double *, const double *, const double *, const double *, double *, double *, int);
+        void (*mul)(const double *, const double *, const double *, const double *, double *, double *, int);
+        void (*conj_mul)(const double *, const double *, const double *, const double *, double *, double *, int);
+        void (*scale)(const double *, const double *, double, double *, double *, int);
+        void (*magnitude)(const double *, const double *, double *, int);
+    };
+
+    // scalar kernels: plain loops over the planes (the compiler vectorizes them with the baseline sse2), also the tails
+    // of the wider kernels
+    void add_scalar(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i != n; ++i) {
+            outr[i] = ar[i] + br[i];
+            outi[i] = ai[i] + bi[i];
+        }
+    }
+
+    // (a + bi)(c + di) = (ac - bd) + (ad + bc)i
+    void mul_scalar(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i != n; ++i) {
+            double r = ar[i] * br[i] - ai[i] * bi[i];
+            double m = ar[i] * bi[i] + ai[i] * br[i];
+            outr[i] = r;
+            outi[i] = m;
+        }
+    }
+
+    // (a + bi)(c - di) = (ac + bd) + (bc - ad)i
+    void conj_mul_scalar(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i != n; ++i) {
+            double r = ar[i] * br[i] + ai[i] * bi[i];
+            double m = ai[i] * br[i] - ar[i] * bi[i];
+            outr[i] = r;
+            outi[i] = m;
+        }
+    }
+
+    void scale_scalar(const double *ar, const double *ai, double s, double *outr, double *outi, int n) {
+        for (int i = 0; i != n; ++i) {
+            outr[i] = ar[i] * s;
+            outi[i] = ai[i] * s;
+        }
+    }
+
+    // sqrt(re^2 + im^2) rather than hypot: hypot guards against overflow past 1e154 but is several times slower
+    void magnitude_scalar(const double *ar, const double *ai, double *out, int n) {
+        for (int i = 0; i != n; ++i) {
+            out[i] = sqrt(ar[i] * ar[i] + ai[i] * ai[i]);
+        }
+    }
+
+    constexpr Kernels scalar_kernels {add_scalar, mul_scalar, conj_mul_scalar, scale_scalar, magnitude_scalar};
+
+#ifdef BRAINTRAIN_X86
+    // the loads are unaligned ones because out may be a slice of someone else's buffer; on the aligned arrays of
+    // ComplexArray they cost the same as aligned loads.
+
+    __attribute__((target("avx2,fma")))
+    void add_avx2(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(outr + i, _mm256_add_pd(_mm256_loadu_pd(ar + i), _mm256_loadu_pd(br + i)));
+            _mm256_storeu_pd(outi + i, _mm256_add_pd(_mm256_loadu_pd(ai + i), _mm256_loadu_pd(bi + i)));
+        }
+        add_scalar(ar + i, ai + i, br + i, bi + i, outr + i, outi + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void mul_avx2(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d a = _mm256_loadu_pd(ar + i), b = _mm256_loadu_pd(ai + i);
+            __m256d c = _mm256_loadu_pd(br + i), d = _mm256_loadu_pd(bi + i);
+            _mm256_storeu_pd(outr + i, _mm256_fmsub_pd(a, c, _mm256_mul_pd(b, d)));
+            _mm256_storeu_pd(outi + i, _mm256_fmadd_pd(a, d, _mm256_mul_pd(b, c)));
+        }
+        mul_scalar(ar + i, ai + i, br + i, bi + i, outr + i, outi + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void conj_mul_avx2(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d a = _mm256_loadu_pd(ar + i), b = _mm256_loadu_pd(ai + i);
+            __m256d c = _mm256_loadu_pd(br + i), d = _mm256_loadu_pd(bi + i);
+            _mm256_storeu_pd(outr + i, _mm256_fmadd_pd(a, c, _mm256_mul_pd(b, d)));
+            _mm256_storeu_pd(outi + i, _mm256_fmsub_pd(b, c, _mm256_mul_pd(a, d)));
+        }
+        conj_mul_scalar(ar + i, ai + i, br + i, bi + i, outr + i, outi + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void scale_avx2(const double *ar, const double *ai, double s, double *outr, double *outi, int n) {
+        __m256d sv = _mm256_set1_pd(s);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(outr + i, _mm256_mul_pd(_mm256_loadu_pd(ar + i), sv));
+            _mm256_storeu_pd(outi + i, _mm256_mul_pd(_mm256_loadu_pd(ai + i), sv));
+        }
+        scale_scalar(ar + i, ai + i, s, outr + i, outi + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void magnitude_avx2(const double *ar, const double *ai, double *out, int n) {
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d a = _mm256_loadu_pd(ar + i), b = _mm256_loadu_pd(ai + i);
+            _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_fmadd_pd(a, a, _mm256_mul_pd(b, b))));
+        }
+        magnitude_scalar(ar + i, ai + i, out + i, n - i);
+    }
+
+    // avx-512: the tail is handled by a masked load/store instead of the scalar loop
+    __attribute__((target("avx512f")))
+    void add_avx512(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i < n; i += 8) {
+            __mmask8 m = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(outr + i, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, ar + i), _mm512_maskz_loadu_pd(m, br + i)));
+            _mm512_mask_storeu_pd(outi + i, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, ai + i), _mm512_maskz_loadu_pd(m, bi + i)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void mul_avx512(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i < n; i += 8) {
+            __mmask8 m = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            __m512d a = _mm512_maskz_loadu_pd(m, ar + i), b = _mm512_maskz_loadu_pd(m, ai + i);
+            __m512d c = _mm512_maskz_loadu_pd(m, br + i), d = _mm512_maskz_loadu_pd(m, bi + i);
+            _mm512_mask_storeu_pd(outr + i, m, _mm512_fmsub_pd(a, c, _mm512_mul_pd(b, d)));
+            _mm512_mask_storeu_pd(outi + i, m, _mm512_fmadd_pd(a, d, _mm512_mul_pd(b, c)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void conj_mul_avx512(const double *ar, const double *ai, const double *br, const double *bi, double *outr, double *outi, int n) {
+        for (int i = 0; i < n; i += 8) {
+            __mmask8 m = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            __m512d a = _mm512_maskz_loadu_pd(m, ar + i), b = _mm512_maskz_loadu_pd(m, ai + i);
+            __m512d c = _mm512_maskz_loadu_pd(m, br + i), d = _mm512_maskz_loadu_pd(m, bi + i);
+            _mm512_mask_storeu_pd(outr + i, m, _mm512_fmadd_pd(a, c, _mm512_mul_pd(b, d)));
+            _mm512_mask_storeu_pd(outi + i, m, _mm512_fmsub_pd(b, c, _mm512_mul_pd(a, d)));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void scale_avx512(const double *ar, const double *ai, double s, double *outr, double *outi, int n) {
+        __m512d sv = _mm512_set1_pd(s);
+        for (int i = 0; i < n; i += 8) {
+            __mmask8 m = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(outr + i, m, _mm512_mul_pd(_mm512_maskz_loadu_pd(m, ar + i), sv));
+            _mm512_mask_storeu_pd(outi + i, m, _mm512_mul_pd(_mm512_maskz_loadu_pd(m, ai + i), sv));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void magnitude_avx512(const double *ar, const double *ai, double *out, int n) {
+        for (int i = 0; i < n; i += 8) {
+            __mmask8 m = n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (n - i)) - 1);
+            __m512d a = _mm512_maskz_loadu_pd(m, ar + i), b = _mm512_maskz_loadu_pd(m, ai + i);
+            _mm512_mask_storeu_pd(out + i, m, _mm512_maskz_sqrt_pd(m, _mm512_fmadd_pd(a, a, _mm512_mul_pd(b, b))));
+        }
+    }
+
+    constexpr Kernels avx2_kernels {add_avx2, mul_avx2, conj_mul_avx2, scale_avx2, magnitude_avx2};
+    constexpr Kernels avx512_kernels {add_avx512, mul_avx512, conj_mul_avx512, scale_avx512, magnitude_avx512};
+#endif
+
+    using cpu::Isa;
+
+    cpu::Dispatch<Kernels> &dispatch() {
+        static cpu::Dispatch<Kernels> d {
+                {Isa::scalar, scalar_kernels},
+#ifdef BRAINTRAIN_X86
+                {Isa::avx2, avx2_kernels},
+                {Isa::avx512, avx512_kernels},
+#endif
+        };
+        return d;
+    }
+
+    const Kernels &kernels() noexcept {
+        return dispatch().kernels();
+    }
+}
+
+ComplexArray::ComplexArray(int n) : length {n}, re {allocate(n)}, im {nullptr} {
+    try {
+        im = allocate(n);
+    } catch (...) {
+        deallocate(re);
+        throw;
+    }
+    fill_n(re, n, 0.0);
+    fill_n(im, n, 0.0);
+    lifecycle::constructed<ComplexArray>(2 * n * sizeof(double));
+}
+
+ComplexArray::ComplexArray(initializer_list<Complex3> init) : ComplexArray(static_cast<int>(init.size())) {
+    int i = 0;
+    for (const Complex3 &c : init) {
+        re[i] = c.real();
+        im[i] = c.imag();
+        i++;
+    }
+}
+
+ComplexArray::ComplexArray(const ComplexArray &a) : length {a.length}, re {allocate(a.length)}, im {nullptr} {
+    try {
+        im = allocate(a.length);
+    } catch (...) {
+        deallocate(re);
+        throw;
+    }
+    copy_n(a.re, length, re);
+    copy_n(a.im, length, im);
+    lifecycle::copied<ComplexArray>(2 * length * sizeof(double));
+}
+
+ComplexArray::ComplexArray(ComplexArray &&a) noexcept : length {a.length}, re {a.re}, im {a.im} {
+    a.length = 0;
+    a.re = nullptr;
+    a.im = nullptr;
+    lifecycle::moved<ComplexArray>();
+}
+
+ComplexArray &ComplexArray::operator=(const ComplexArray &a) {
+    if (&a == this) {
+        return *this;
+    }
+    long bytes = 0;
+    if (a.length != length) { // a different length needs new planes: allocate both before freeing anything (strong guarantee)
+        double *fresh_re = allocate(a.length);
+        double *fresh_im;
+        try {
+            fresh_im = allocate(a.length);
+        } catch (...) {
+            deallocate(fresh_re);
+            throw;
+        }
+        deallocate(re);
+        deallocate(im);
+        re = fresh_re;
+        im = fresh_im;
+        length = a.length;
+        bytes = 2 * length * sizeof(double);
+    }
+    copy_n(a.re, length, re);
+    copy_n(a.im, length, im);
+    lifecycle::copy_assigned<ComplexArray>(bytes);
+    return *this;
+}
+
+ComplexArray &ComplexArray::operator=(ComplexArray &&a) noexcept {
+    if (&a == this) {
+        return *this;
+    }
+    deallocate(re);
+    deallocate(im);
+    length = a.length;
+    re = a.re;
+    im = a.im;
+    a.length = 0;
+    a.re = nullptr;
+    a.im = nullptr;
+    lifecycle::move_assigned<ComplexArray>();
+    return *this;
+}
+
+ComplexArray::~ComplexArray() {
+    deallocate(re);
+    deallocate(im);
+    lifecycle::destroyed<ComplexArray>();
+}
+
+Complex3 ComplexArray::get(int i) const {
+    if (i < 0 || i >= length) {
+        throw out_of_range("index " + to_string(i) + " outside [0, " + to_string(length) + ")");
+    }
+    return {re[i], im[i]};
+}
+
+void ComplexArray::set(int i, double r, double m) {
+    if (i < 0 || i >= length) {
+        throw out_of_range("index " + to_string(i) + " outside [0, " + to_string(length) + ")");
+    }
+    re[i] = r;
+    im[i] = m;
+}
+
+void ComplexArray::set(int i, const Complex3 &c) {
+    set(i, c.real(), c.imag());
+}
+
+ComplexArray &ComplexArray::operator+=(const ComplexArray &a) {
+    add(*this, a, *this);
+    return *this;
+}
+
+ComplexArray &ComplexArray::operator*=(const ComplexArray &a) {
+    mul(*this, a, *this);
+    return *this;
+}
+
+ComplexArray &ComplexArray::operator*=(double s) {
+    scale(*this, s, *this);
+    return *this;
+}
+
+ComplexArray &ComplexArray::conj_mul(const ComplexArray &a) {
+    ::conj_mul(*this, a, *this);
+    return *this;
+}
+
+void ComplexArray::magnitude(double *out) const {
+    kernels().magnitude(re, im, out, length);
+}
+
+const char *ComplexArray::simd_name() noexcept {
+    return cpu::isa_name(dispatch().active());
+}
+
+bool ComplexArray::use_simd(bool on) noexcept {
+    cpu::Dispatch<Kernels> &d = dispatch();
+    bool was = d.active() != Isa::scalar;
+    d.use(on ? Isa::avx512 : Isa::scalar);
+    return was;
+}
+
+void add(const ComplexArray &a, const ComplexArray &b, ComplexArray &out) {
+    check_lengths(a, b);
+    check_lengths(a, out);
+    kernels().add(a.real_data(), a.imag_data(), b.real_data(), b.imag_data(), out.real_data(), out.imag_data(), a.get_size());
+}
+
+void mul(const ComplexArray &a, const ComplexArray &b, ComplexArray &out) {
+    check_lengths(a, b);
+    check_lengths(a, out);
+    kernels().mul(a.real_data(), a.imag_data(), b.real_data(), b.imag_data(), out.real_data(), out.imag_data(), a.get_size());
+}
+
+void conj_mul(const ComplexArray &a, const ComplexArray &b, ComplexArray &out) {
+    check_lengths(a, b);
+    check_lengths(a, out);
+    kernels().conj_mul(a.real_data(), a.imag_data(), b.real_data(), b.imag_data(), out.real_data(), out.imag_data(), a.get_size());
+}
+
+void scale(const ComplexArray &a, double s, ComplexArray &out) {
+    check_lengths(a, out);
+    kernels().scale(a.real_data(), a.imag_data(), s, out.real_data(), out.imag_data(), a.get_size());
+}
@@ -0,0 +1,269 @@
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "headers/FFT.h"
+
+using namespace std;
+
+namespace fft {
+namespace {
+    struct Pass {
+        int m;         // the size of the sub-transforms this pass combines (into transforms of radix * m)
+        int radix;     // 2 or 4
+        size_t offset; // where its twiddles start in Plan::tw_re/tw_im
+    };
+
+    // everything that depends only on n
+    struct Plan {
+        int n;
+        vector<pair<int, int>> swaps; // the bit-reversal permutation as the pairs to swap (i < rev(i))
+        vector<Pass> passes;
+        // the twiddles of a radix-4 pass are w^j, w^2j and w^3j for j in [0, m), w = exp(-2 pi i / 4m), one after the
+        // other so the inner loop reads them sequentially (and the re and im in separate arrays, like ComplexArray)
+        vector<double> tw_re;
+        vector<double> tw_im;
+        // exp(-2 pi i k / 2n) for k in [0, n): untangles a real transform of 2n samples done as this complex one of n
+        vector<double> real_re;
+        vector<double> real_im;
+
+        explicit Plan(int size) : n {size} {
+            int bits = 0;
+            while ((1 << bits) < n) {
+                bits++;
+            }
+            for (int i = 0; i != n; i++) {
+                int r = 0;
+                for (int b = 0; b != bits; b++) {
+                    r |= ((i >> b) & 1) << (bits - 1 - b);
+                }
+                if (i < r) {
+                    swaps.emplace_back(i, r);
+                }
+            }
+
+            int m = 1;
+            if (bits % 2 == 1) { // its twiddles are all 1
+                passes.push_back({m, 2, 0});
+                m *= 2;
+            }
+            for (; m < n; m *= 4) {
+                passes.push_back({m, 4, tw_re.size()});
+                for (int r = 1; r <= 3; r++) {
+                    for (int j = 0; j != m; j++) {
+                        double angle = -2 * numbers::pi * r * j / (4.0 * m);
+                        tw_re.push_back(cos(angle));
+                        tw_im.push_back(sin(angle));
+                    }
+                }
+            }
+
+            for (int k = 0; k != n; k++) {
+                double angle = -numbers::pi * k / n;
+                real_re.push_back(cos(angle));
+                real_im.push_back(sin(angle));
+            }
+        }
+    };
+
+    mutex plans_mtx;
+    unordered_map<int, shared_ptr<const Plan>> plans;
+
+    shared_ptr<const Plan> plan_for(int n) {
+        if (n < 1 || (n & (n - 1)) != 0) {
+            throw invalid_argument("fft length must be a power of 2: " + to_string(n));
+        }
+        // most callers transform the same size over and over: remember the last plan per thread and skip the lock
+        thread_local shared_ptr<const Plan> last;
+        if (last && last->n == n) {
+            return last;
+        }
+        scoped_lock sl {plans_mtx};
+        shared_ptr<const Plan> &p = plans[n];
+        if (!p) {
+            p = make_shared<const Plan>(n);
+        }
+        last = p;
+        return p;
+    }
+
+    void radix2(double *re, double *im, int n) {
+        for (int k = 0; k < n; k += 2) {
+            double ar = re[k], ai = im[k], br = re[k + 1], bi = im[k + 1];
+            re[k] = ar + br;
+            im[k] = ai + bi;
+            re[k + 1] = ar - br;
+            im[k + 1] = ai - bi;
+        }
+    }
+
+    // combines 4 transforms of size m into one of size 4m. After the bit reversal the 4 inputs of output j sit at
+    // k + j (the samples = 0 mod 4), k + m + j (= 2 mod 4), k + 2m + j (= 1 mod 4) and k + 3m + j (= 3 mod 4).
+    // The j loop has no dependencies between iterations and reads everything sequentially, so it vectorizes.
+    void radix4(double *re, double *im, int n, int m, const double *w_re, const double *w_im) {
+        const double *w1r = w_re, *w2r = w_re + m, *w3r = w_re + 2 * m;
+        const double *w1i = w_im, *w2i = w_im + m, *w3i = w_im + 2 * m;
+        for (int k = 0; k < n; k += 4 * m) {
+            double *r0 = re + k, *r1 = re + k + m, *r2 = re + k + 2 * m, *r3 = re + k + 3 * m;
+            double *i0 = im + k, *i1 = im + k + m, *i2 = im + k + 2 * m, *i3 = im + k + 3 * m;
+            for (int j = 0; j < m; j++) {
+                double b0r = r0[j], b0i = i0[j];
+                // b1 = x[1 mod 4] * w^j, b2 = x[2 mod 4] * w^2j, b3 = x[3 mod 4] * w^3j
+                double b1r = r2[j] * w1r[j] - i2[j] * w1i[j], b1i = r2[j] * w1i[j] + i2[j] * w1r[j];
+                double b2r = r1[j] * w2r[j] - i1[j] * w2i[j], b2i = r1[j] * w2i[j] + i1[j] * w2r[j];
+                double b3r = r3[j] * w3r[j] - i3[j] * w3i[j], b3i = r3[j] * w3i[j] + i3[j] * w3r[j];
+
+                double t0r = b0r + b2r, t0i = b0i + b2i;
+                double t1r = b0r - b2r, t1i = b0i - b2i;
+                double t2r = b1r + b3r, t2i = b1i + b3i;
+                double t3r = b1r - b3r, t3i = b1i - b3i;
+
+                r0[j] = t0r + t2r; // X[j]
+                i0[j] = t0i + t2i;
+                r1[j] = t1r + t3i; // X[j + m] = t1 - i t3
+                i1[j] = t1i - t3r;
+                r2[j] = t0r - t2r; // X[j + 2m]
+                i2[j] = t0i - t2i;
+                r3[j] = t1r - t3i; // X[j + 3m] = t1 + i t3
+                i3[j] = t1i + t3r;
+            }
+        }
+    }
+
+    void transform(const Plan &plan, double *re, double *im) {
+        for (auto [a, b] : plan.swaps) {
+            swap(re[a], re[b]);
+            swap(im[a], im[b]);
+        }
+        for (const Pass &p : plan.passes) {
+            if (p.radix == 2) {
+                radix2(re, im, plan.n);
+            } else {
+                radix4(re, im, plan.n, p.m, plan.tw_re.data() + p.offset, plan.tw_im.data() + p.offset);
+            }
+        }
+    }
+
+    // the inverse is the forward transform of the conjugate, conjugated and scaled: ifft(x) = conj(fft(conj(x))) / n
+    void transform_inverse(const Plan &plan, double *re, double *im) {
+        for (int i = 0; i != plan.n; i++) {
+            im[i] = -im[i];
+        }
+        transform(plan, re, im);
+        double s = 1.0 / plan.n;
+        for (int i = 0; i != plan.n; i++) {
+            re[i] *= s;
+            im[i] *= -s;
+        }
+    }
+}
+
+void forward(double *re, double *im, int n) {
+    transform(*plan_for(n), re, im);
+}
+
+void inverse(double *re, double *im, int n) {
+    transform_inverse(*plan_for(n), re, im);
+}
+
+void forward(ComplexArray &a) {
+    forward(a.real_data(), a.imag_data(), a.get_size());
+}
+
+void inverse(ComplexArray &a) {
+    inverse(a.real_data(), a.imag_data(), a.get_size());
+}
+
+// z[k] = x[2k] + i x[2k+1] is transformed as n/2 complex numbers: Z = E + i O where E and O are the transforms of the
+// even and the odd samples. Since those are real, E[k] = (Z[k] + conj(Z[h-k])) / 2 and O[k] = (Z[k] - conj(Z[h-k])) / 2i,
+// and X[k] = E[k] + w^k O[k] with w = exp(-2 pi i / n)
+ComplexArray forward_real(const double *x, int n) {
+    if (n < 2) {
+        throw invalid_argument("real fft length must be at least 2: " + to_string(n));
+    }
+    if ((n & (n - 1)) != 0) {
+        throw invalid_argument("fft length must be a power of 2: " + to_string(n));
+    }
+    int h = n / 2;
+    shared_ptr<const Plan> plan = plan_for(h);
+    ComplexArray bins(h + 1);
+    double *re = bins.real_data(), *im = bins.imag_data();
+    for (int k = 0; k != h; k++) {
+        re[k] = x[2 * k];
+        im[k] = x[2 * k + 1];
+    }
+    transform(*plan, re, im);
+
+    double z0r = re[0], z0i = im[0];
+    re[0] = z0r + z0i;
+    im[0] = 0;
+    re[h] = z0r - z0i;
+    im[h] = 0;
+    // bin a from Z[a] = (ar, ai) and its partner Z[h-a] = (br, bi)
+    auto untangle = [&](int a, double ar, double ai, double br, double bi) {
+        double er = (ar + br) / 2, ei = (ai - bi) / 2;  // E = (Z[a] + conj(Z[h-a])) / 2
+        double or_ = (ai + bi) / 2, oi = (br - ar) / 2; // O = (Z[a] - conj(Z[h-a])) / 2i
+        double wr = plan->real_re[a], wi = plan->real_im[a];
+        re[a] = er + wr * or_ - wi * oi;
+        im[a] = ei + wr * oi + wi * or_;
+    };
+    // k and h - k read each other so they are done in pairs (the middle one, k == h/2, is its own partner)
+    for (int k = 1; k <= h / 2; k++) {
+        int l = h - k;
+        double zkr = re[k], zki = im[k], zlr = re[l], zli = im[l];
+        untangle(k, zkr, zki, zlr, zli);
+        if (l != k) {
+            untangle(l, zlr, zli, zkr, zki);
+        }
+    }
+    return bins;
+}
+
+// undoes the untangling: E[k] = (X[k] + conj(X[h-k])) / 2 and O[k] = (X[k] - conj(X[h-k])) conj(w^k) / 2, then
+// Z = E + i O is inverse transformed and the samples are read back out of the re/im pairs
+void inverse_real(const ComplexArray &bins, double *x, int n) {
+    if (n < 2) {
+        throw invalid_argument("real fft length must be at least 2: " + to_string(n));
+    }
+    if ((n & (n - 1)) != 0) {
+        throw invalid_argument("fft length must be a power of 2: " + to_string(n));
+    }
+    int h = n / 2;
+    shared_ptr<const Plan> plan = plan_for(h);
+    if (bins.get_size() != h + 1) {
+        throw length_error("inverse_real of " + to_string(n) + " samples needs " + to_string(h + 1) + " bins, got " +
+                           to_string(bins.get_size()));
+    }
+    const double *xr = bins.real_data(), *xi = bins.imag_data();
+    vector<double> zr(h), zi(h);
+    for (int k = 0; k != h; k++) {
+        int l = h - k;
+        double er = (xr[k] + xr[l]) / 2, ei = (xi[k] - xi[l]) / 2;
+        double dr = (xr[k] - xr[l]) / 2, di = (xi[k] + xi[l]) / 2; // (X[k] - conj(X[h-k])) / 2
+        double wr = plan->real_re[k], wi = -plan->real_im[k];     // conj(w^k)
+        double or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        zr[k] = er - oi; // E + i O
+        zi[k] = ei + or_;
+    }
+    transform_inverse(*plan, zr.data(), zi.data());
+    for (int k = 0; k != h; k++) {
+        x[2 * k] = zr[k];
+        x[2 * k + 1] = zi[k];
+    }
+}
+
+size_t cached_plans() {
+    scoped_lock sl {plans_mtx};
+    return plans.size();
+}
+
+void clear_plans() {
+    scoped_lock sl {plans_mtx};
+    plans.clear(); // the threads' last plans are shared_ptrs so whoever is using one keeps it alive
+}
+}
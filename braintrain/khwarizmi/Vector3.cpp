@@ -1,38 +1,51 @@
 #include "headers/Vector3.h"
-#include <iostream>
+#include "../common/headers/Lifecycle.h"
 
 using namespace std;
 
-Vector3::Vector3(int len) {
-    cout << "Vector3-conversion-cntr is called" << endl;
+Vector3::Vector3(int len, pmr::memory_resource *resource): alloc {resource} {
     if (len < 0) {
         throw length_error("negative vector length: " + to_string(len));
     }
+    lifecycle::constructed<Vector3>(len * sizeof(double));
     length = len;
-    items = new double[len];
+    items = alloc.allocate(len);
 }
 
-Vector3::Vector3(initializer_list<double> init): length {static_cast<int>(init.size())}, items{new double[length]} {
-    cout << "Vector3-initializer-list-cntr is called" << endl;
+Vector3::Vector3(initializer_list<double> init, pmr::memory_resource *resource): alloc {resource},
+        length {static_cast<int>(init.size())}, items{alloc.allocate(length)} {
+    lifecycle::constructed<Vector3>(length * sizeof(double));
     copy(init.begin(), init.end(), items);
 }
 
-Vector3::Vector3(const Vector3 & v): length {v.length}, items {new double[v.length]} { // copy cntr
-    cout << "Vector3-copy-cntr is called" << endl;
+Vector3::Vector3(const Vector3 & v): Vector3(v, pmr::get_default_resource()) {} // copy cntr
+
+Vector3::Vector3(const Vector3 &v, pmr::memory_resource *resource): alloc {resource}, length {v.length},
+        items {alloc.allocate(v.length)} {
+    lifecycle::copied<Vector3>(length * sizeof(double));
     for (int i = 0; i != length; ++i) {
         items[i] = v.items[i];
     }
 }
 
-Vector3::Vector3(Vector3 &&v) noexcept: length {v.length}, items {v.items} { // move cntr
-    cout << "Vector3-move-cntr is called" << endl;
+Vector3::Vector3(Vector3 &&v) noexcept: alloc {v.alloc}, length {v.length}, items {v.items} { // move cntr
+    lifecycle::moved<Vector3>();
     v.length = 0;
     v.items = nullptr;
 }
 
-Vector3 &Vector3::operator=(Vector3 &&v) noexcept { // move-assignment
-    cout << "Vector3-move-assign is called" << endl;
-    delete [] items;
+Vector3 &Vector3::operator=(Vector3 &&v) { // move-assignment
+    if (&v == this) {
+        return *this; // v = std::move(v): freeing items and then taking them back would leave a dangling buffer
+    }
+    if (alloc != v.alloc) {
+        // v's buffer lives in another arena: taking it would leave us dangling when that arena is released
+        return *this = static_cast<const Vector3 &>(v);
+    }
+    if (items) {
+        alloc.deallocate(items, length);
+    }
+    lifecycle::move_assigned<Vector3>();
     length = v.length;
     items = v.items;
 
@@ -43,27 +56,36 @@ Vector3 &Vector3::operator=(Vector3 &&v) noexcept { // move-assignment
 
 // handle self-assign
 Vector3 &Vector3::operator=(const Vector3 &v) { // copy-assignment
-    cout << "Vector3-copy-assign is called" << endl;
+    lifecycle::copy_assigned<Vector3>(v.length * sizeof(double));
     double* old = items;
+    int old_length = length;
 
-    items = new double[v.length];
+    items = alloc.allocate(v.length); // we keep our resource (pmr allocators do not propagate on assignment)
     length = v.length;
     for (int i = 0; i < v.length; i++) {
         items[i] = v.items[i];
     }
-    delete [] old;
+    if (old) {
+        alloc.deallocate(old, old_length);
+    }
     return *this;
 }
 
 Vector3::~Vector3() {
-    cout << "Vector3-destructor is called" << endl;
-    delete [] items; // plain delete deletes a single object, delete[] deletes the array
+    lifecycle::destroyed<Vector3>();
+    if (items) {
+        alloc.deallocate(items, length); // a no-op when the resource is a monotonic arena: it frees everything at once
+    }
 }
 
 int Vector3::get_size() const {
     return length;
 }
 
+pmr::memory_resource *Vector3::get_resource() const {
+    return alloc.resource();
+}
+
 double &Vector3::operator[](int i) {
     return items[i];
 }
@@ -71,3 +93,11 @@ double &Vector3::operator[](int i) {
 const double &Vector3::operator[](int i) const {
     return items[i];
 }
+
+double *Vector3::begin() const {
+    return items;
+}
+
+double *Vector3::end() const {
+    return items + length;
+}
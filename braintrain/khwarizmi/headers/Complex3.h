@@ -11,7 +11,12 @@ public:
 
     Complex3(double, double);
 
-    Complex3(Complex3&);
+    Complex3(const Complex3&);
+
+    // spelled out since the copy constructor is user declared (relying on the implicit one is deprecated), and counted
+    Complex3& operator=(const Complex3&);
+
+    ~Complex3();
 
     [[nodiscard]] double real() const;
 
@@ -19,7 +24,7 @@ public:
 
     Complex3& operator+=(Complex3 &c);
 
-    Complex3& operator*=(Complex3 c1); // concrete class does not have to implement all header funcs
+    Complex3& operator*=(Complex3 c1); // a concrete class does not have to implement all header funcs (it used to not)
 };
 
 #endif //CPP_COMPLEX3_H
@@ -0,0 +1,79 @@
+#ifndef BRAINTRAIN_COMPLEXARRAY_H
+#define BRAINTRAIN_COMPLEXARRAY_H
+
+#include <initializer_list>
+#include "Complex3.h"
+
+using namespace std;
+
+// a structure-of-arrays alternative to an array of Complex3: all the real parts in one array and all the imaginary parts
+// in another (both aligned on a cache line). A simd register then holds 4 (avx2) or 8 (avx-512) real parts and the
+// arithmetic needs no shuffling, where an array of Complex3 interleaves re,im,re,im and has to be split apart first.
+// The kernels are picked at runtime like the einstein reductions (avx-512, avx2+fma, or plain loops the compiler
+// vectorizes to sse2).
+class ComplexArray {
+private:
+    int length;
+    double *re;
+    double *im;
+public:
+    explicit ComplexArray(int); // n zeroes
+
+    ComplexArray(initializer_list<Complex3>);
+
+    ComplexArray(const ComplexArray &);
+
+    ComplexArray(ComplexArray &&) noexcept;
+
+    ComplexArray &operator=(const ComplexArray &);
+
+    ComplexArray &operator=(ComplexArray &&) noexcept;
+
+    ~ComplexArray();
+
+    [[nodiscard]] int get_size() const noexcept { return length; }
+
+    // element access copies in and out (there is no Complex3 in memory to hand out a reference to)
+    [[nodiscard]] Complex3 get(int) const;
+
+    void set(int, double, double);
+
+    void set(int, const Complex3 &);
+
+    [[nodiscard]] double *real_data() noexcept { return re; }
+
+    [[nodiscard]] const double *real_data() const noexcept { return re; }
+
+    [[nodiscard]] double *imag_data() noexcept { return im; }
+
+    [[nodiscard]] const double *imag_data() const noexcept { return im; }
+
+    // element-wise, in place. All of them throw length_error when the lengths differ
+    ComplexArray &operator+=(const ComplexArray &);
+
+    ComplexArray &operator*=(const ComplexArray &);
+
+    ComplexArray &operator*=(double); // scale
+
+    ComplexArray &conj_mul(const ComplexArray &); // this * conj(other), the building block of correlations
+
+    // |z| of every element into out (which must hold get_size() doubles)
+    void magnitude(double *out) const;
+
+    // which kernels are in use, and a switch to the plain loops for benchmarking (safe while other threads compute).
+    // use_simd returns the previous setting
+    static const char *simd_name() noexcept;
+
+    static bool use_simd(bool) noexcept;
+};
+
+// out = a op b. out can be a or b (every element is read before it is written)
+void add(const ComplexArray &a, const ComplexArray &b, ComplexArray &out);
+
+void mul(const ComplexArray &a, const ComplexArray &b, ComplexArray &out);
+
+void conj_mul(const ComplexArray &a, const ComplexArray &b, ComplexArray &out);
+
+void scale(const ComplexArray &a, double s, ComplexArray &out);
+
+#endif //BRAINTRAIN_COMPLEXARRAY_H
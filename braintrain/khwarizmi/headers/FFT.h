@@ -0,0 +1,36 @@
+#ifndef BRAINTRAIN_FFT_H
+#define BRAINTRAIN_FFT_H
+
+#include <cstddef>
+#include "ComplexArray.h"
+
+// in-place fast fourier transform over the planes of a ComplexArray (or any pair of re/im arrays), so the data never has
+// to be copied into another library's layout.
+// The lengths must be powers of 2 (invalid_argument otherwise). The transform is iterative: a bit-reversal permutation
+// and then radix-4 passes (plus one radix-2 pass when log2(n) is odd) - half the passes over memory of a plain radix-2
+// one. The twiddle factors are computed once per size, laid out contiguously per pass, and cached.
+// forward is unscaled, inverse scales by 1/n so inverse(forward(x)) == x.
+namespace fft {
+    void forward(ComplexArray &);
+
+    void inverse(ComplexArray &);
+
+    void forward(double *re, double *im, int n);
+
+    void inverse(double *re, double *im, int n);
+
+    // the real-input fast path: n real samples are packed into an n/2 complex transform and untangled afterwards, about
+    // half the work of transforming them as complex numbers with a zero imag part. A real signal has a symmetric spectrum
+    // so only bins 0..n/2 are returned (the rest are their conjugates). n >= 2
+    ComplexArray forward_real(const double *x, int n);
+
+    // the inverse of forward_real: n/2 + 1 bins back to n real samples
+    void inverse_real(const ComplexArray &bins, double *x, int n);
+
+    // the plans (twiddles + permutation) in the cache, and a way to drop them
+    size_t cached_plans();
+
+    void clear_plans();
+}
+
+#endif //BRAINTRAIN_FFT_H
@@ -2,35 +2,105 @@
 #define BRAINTRAIN_VECTOR3_H
 
 #include <initializer_list>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include "../../common/headers/Lifecycle.h"
 
+class Vector3;
+
+// marks the types that take part in the lazy arithmetic of Vector3Expr.h (Vector3 itself and the expression nodes)
+template<typename E>
+inline constexpr bool is_vector3_expr = false;
+
+template<>
+inline constexpr bool is_vector3_expr<Vector3> = true;
+
+template<typename E>
+concept Vector3Expression = is_vector3_expr<std::remove_cvref_t<E>>;
+
+// the buffer comes from a std::pmr::memory_resource (the heap by default). Pass a monotonic_buffer_resource to keep all the
+// vectors of a request in one arena that is released in one go. Vector3 is not a template so the allocator is the
+// runtime-polymorphic one rather than a template parameter (TVector in riemann takes the template route)
 class Vector3 {
 
 private:
+    std::pmr::polymorphic_allocator<double> alloc;
     int length;
     double *items;
 public:
-    explicit Vector3(int); // no implicit conversion from int to vector
+    // no implicit conversion from int to vector
+    explicit Vector3(int, std::pmr::memory_resource * = std::pmr::get_default_resource());
+
+    Vector3(std::initializer_list<double>, std::pmr::memory_resource * = std::pmr::get_default_resource());
+
+    // copy-cntr: like the std pmr containers the copy does NOT inherit the resource (it goes to the default one),
+    // a copy living longer than the arena of the original would dangle otherwise
+    Vector3(const Vector3&);
 
-    Vector3(std::initializer_list<double>);
+    Vector3(const Vector3&, std::pmr::memory_resource *); // copy into a given arena
 
-    Vector3(const Vector3&); //copy-cntr
+    Vector3(Vector3&&) noexcept ; // move-cntr: takes the buffer along with the resource it came from
 
-    Vector3(Vector3&&) noexcept ; // move-cntr
+    // evaluates an expression like a*2 + b element by element straight into our buffer: no temporary Vector3 is created
+    template<Vector3Expression E>
+    Vector3(const E &expr, std::pmr::memory_resource *resource = std::pmr::get_default_resource()):
+            alloc {resource}, length {expr.get_size()}, items {alloc.allocate(expr.get_size())} {
+        lifecycle::constructed<Vector3>(length * sizeof(double));
+        assign(expr);
+    }
 
     ~Vector3();
 
     Vector3 &operator=(const Vector3&); // copy assignment
 
-    Vector3 &operator=(Vector3&&) noexcept ; // move assignment
+    // move assignment: steals the buffer when both use the same resource; otherwise the elements are copied into our own
+    // resource (so it can allocate and is not noexcept)
+    Vector3 &operator=(Vector3&&);
+
+    // reuses our buffer when the lengths match. v = v*2 + w is fine since every element only reads its own index
+    template<Vector3Expression E>
+    Vector3 &operator=(const E &expr) {
+        if (expr.get_size() != length) {
+            lifecycle::allocated<Vector3>(expr.get_size() * sizeof(double));
+            double *fresh = alloc.allocate(expr.get_size());
+            for (int i = 0; i != expr.get_size(); ++i) { // evaluate before freeing in case expr reads this vector
+                fresh[i] = expr[i];
+            }
+            if (items) {
+                alloc.deallocate(items, length);
+            }
+            items = fresh;
+            length = expr.get_size();
+            return *this;
+        }
+        assign(expr);
+        return *this;
+    }
 
     // const signifies that this func doesn't modify its object. It can be called by const and non-const objects
     // however non-const funcs cannot be called by const objects (talk about simplicity!)
     [[nodiscard]] int get_size() const;
 
+    [[nodiscard]] std::pmr::memory_resource *get_resource() const;
+
     double &operator[](int); // get the subscript and alter it if you want
 
     // the left const enables calling the subscript op by const, the right const indicates that the op does not alter this object
     const double &operator[](int) const;
+
+    // raw pointers like TVector: range-for, and the views of riemann/headers/Views.h
+    double *begin() const;
+
+    double *end() const;
+
+private:
+    template<Vector3Expression E>
+    void assign(const E &expr) {
+        for (int i = 0; i != length; ++i) {
+            items[i] = expr[i];
+        }
+    }
 };
 
 
@@ -0,0 +1,132 @@
+#ifndef BRAINTRAIN_VECTOR3EXPR_H
+#define BRAINTRAIN_VECTOR3EXPR_H
+
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include "Vector3.h"
+
+// expression templates: a*2 + b does not compute anything, it builds a small tree of nodes (on the stack) that describes
+// the computation. The work happens once, element by element, when the tree is assigned to a Vector3 - so there is one
+// pass over memory and no temporary Vector3 (valarray does the same trick, check valarray_example in kubernetes.cpp)
+
+// leaves (Vector3) are held by reference, inner nodes by value: nodes are tiny and the expression dies at the end of the
+// full statement that created it. So don't store an expression in an auto variable that outlives its operands.
+template<typename E>
+using vector3_operand = std::conditional_t<std::is_same_v<std::remove_cvref_t<E>, Vector3>, const Vector3 &, std::remove_cvref_t<E>>;
+
+template<typename L, typename R, typename Op>
+class Vector3Binary {
+private:
+    vector3_operand<L> lhs;
+    vector3_operand<R> rhs;
+public:
+    Vector3Binary(const L &l, const R &r): lhs {l}, rhs {r} {
+        if (l.get_size() != r.get_size()) {
+            throw std::length_error("vector lengths differ: " + std::to_string(l.get_size()) + " and " + std::to_string(r.get_size()));
+        }
+    }
+
+    [[nodiscard]] int get_size() const { return lhs.get_size(); }
+
+    double operator[](int i) const { return Op{}(lhs[i], rhs[i]); }
+};
+
+// vector op scalar (or scalar op vector when ScalarFirst is set: 2 - v is not v - 2)
+template<typename E, typename Op, bool ScalarFirst = false>
+class Vector3Scalar {
+private:
+    vector3_operand<E> expr;
+    double scalar;
+public:
+    Vector3Scalar(const E &e, double s): expr {e}, scalar {s} {}
+
+    [[nodiscard]] int get_size() const { return expr.get_size(); }
+
+    double operator[](int i) const { return ScalarFirst ? Op{}(scalar, expr[i]) : Op{}(expr[i], scalar); }
+};
+
+template<typename E>
+class Vector3Negate {
+private:
+    vector3_operand<E> expr;
+public:
+    explicit Vector3Negate(const E &e): expr {e} {}
+
+    [[nodiscard]] int get_size() const { return expr.get_size(); }
+
+    double operator[](int i) const { return -expr[i]; }
+};
+
+// a*b + c with a single rounding per element (std::fma)
+template<typename A, typename B, typename C>
+class Vector3Fma {
+private:
+    vector3_operand<A> a;
+    vector3_operand<B> b;
+    vector3_operand<C> c;
+public:
+    Vector3Fma(const A &x, const B &y, const C &z): a {x}, b {y}, c {z} {
+        if (x.get_size() != y.get_size() || x.get_size() != z.get_size()) {
+            throw std::length_error("vector lengths differ in fma");
+        }
+    }
+
+    [[nodiscard]] int get_size() const { return a.get_size(); }
+
+    double operator[](int i) const { return std::fma(a[i], b[i], c[i]); }
+};
+
+// the nodes are expressions too, so they can be nested
+template<typename L, typename R, typename Op>
+inline constexpr bool is_vector3_expr<Vector3Binary<L, R, Op>> = true;
+
+template<typename E, typename Op, bool ScalarFirst>
+inline constexpr bool is_vector3_expr<Vector3Scalar<E, Op, ScalarFirst>> = true;
+
+template<typename E>
+inline constexpr bool is_vector3_expr<Vector3Negate<E>> = true;
+
+template<typename A, typename B, typename C>
+inline constexpr bool is_vector3_expr<Vector3Fma<A, B, C>> = true;
+
+// the operators are constrained by the concept so they never kick in for anything else (ints, valarray, etc.)
+// vector * vector is element-wise like valarray (not a dot product)
+template<Vector3Expression L, Vector3Expression R>
+auto operator+(const L &l, const R &r) { return Vector3Binary<L, R, std::plus<>>(l, r); }
+
+template<Vector3Expression L, Vector3Expression R>
+auto operator-(const L &l, const R &r) { return Vector3Binary<L, R, std::minus<>>(l, r); }
+
+template<Vector3Expression L, Vector3Expression R>
+auto operator*(const L &l, const R &r) { return Vector3Binary<L, R, std::multiplies<>>(l, r); }
+
+template<Vector3Expression E>
+auto operator+(const E &e, double s) { return Vector3Scalar<E, std::plus<>>(e, s); }
+
+template<Vector3Expression E>
+auto operator+(double s, const E &e) { return Vector3Scalar<E, std::plus<>, true>(e, s); }
+
+template<Vector3Expression E>
+auto operator-(const E &e, double s) { return Vector3Scalar<E, std::minus<>>(e, s); }
+
+template<Vector3Expression E>
+auto operator-(double s, const E &e) { return Vector3Scalar<E, std::minus<>, true>(e, s); }
+
+template<Vector3Expression E>
+auto operator*(const E &e, double s) { return Vector3Scalar<E, std::multiplies<>>(e, s); }
+
+template<Vector3Expression E>
+auto operator*(double s, const E &e) { return Vector3Scalar<E, std::multiplies<>, true>(e, s); }
+
+template<Vector3Expression E>
+auto operator/(const E &e, double s) { return Vector3Scalar<E, std::divides<>>(e, s); }
+
+template<Vector3Expression E>
+auto operator-(const E &e) { return Vector3Negate<E>(e); }
+
+template<Vector3Expression A, Vector3Expression B, Vector3Expression C>
+auto fma(const A &a, const B &b, const C &c) { return Vector3Fma<A, B, C>(a, b, c); }
+
+#endif //BRAINTRAIN_VECTOR3EXPR_H
@@ -1,7 +1,17 @@
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <numbers>
 #include <vector>
+#include <memory_resource>
 #include "headers/Complex3.h"
+#include "headers/ComplexArray.h"
+#include "headers/FFT.h"
 #include "headers/Vector3.h"
+#include "headers/Vector3Expr.h"
+#include "../riemann/headers/Views.h"
 
 using namespace std;
 
@@ -141,6 +151,234 @@ void vector_iteration() {
     cout << endl;
 }
 
+// chained arithmetic on Vector3 builds an expression that is evaluated in one pass: build with BRAINTRAIN_LIFECYCLE and
+// the report shows no copy/move/destructor of temporaries, the result is the only Vector3 constructed
+void expression_templates() {
+    cout << "==>>expression_templates" << endl;
+    Vector3 a {1, -2, 3};
+    Vector3 b {4, 5, 6};
+
+    Vector3 r = a*2 + b; // same as a1*2 + a2 in valarray_example (kubernetes.cpp)
+    cout << r[0] << ", " << r[1] << ", " << r[2] << endl;
+
+    r = fma(a, b, r) - 1; // assigning to an existing vector of the same length does not even allocate
+    cout << r[0] << ", " << r[1] << ", " << r[2] << endl;
+
+    r = -(r / 2) + a * b; // r appears on both sides: safe since element i only reads index i
+    cout << r[0] << ", " << r[1] << ", " << r[2] << endl;
+
+    try {
+        Vector3 c {1, 2};
+        Vector3 bad = a + c;
+    } catch (length_error &e) {
+        cout << "caught it: " << e.what() << endl;
+    }
+}
+
+// all the vectors of a 'request' come from one arena: the monotonic resource hands out memory by bumping a pointer and
+// the destructors' deallocate calls are no-ops. Everything is released at once when the arena goes out of scope
+void arena_vectors() {
+    cout << "==>>arena_vectors" << endl;
+    std::byte buffer[1024]; // the arena starts on the stack and only goes to the heap if this runs out
+    pmr::monotonic_buffer_resource arena {buffer, sizeof(buffer)};
+
+    Vector3 a {{1, 2, 3}, &arena};
+    Vector3 b {a * 2, &arena};
+    Vector3 c {b, &arena}; // copy into the arena
+
+    Vector3 d = a; // a plain copy goes to the default (heap) resource so it can outlive the arena
+    cout << "d from arena: " << (d.get_resource() == &arena) << " - c from arena: " << (c.get_resource() == &arena) << endl;
+
+    d = std::move(c); // different resources: the elements are copied, c's buffer stays in the arena
+    cout << d[0] << ", " << d[1] << ", " << d[2] << endl;
+}
+
+void complex_arrays() {
+    cout << "==>>complex_arrays" << endl;
+    Complex3 c1 {1, 2};
+    Complex3 c2 {3, -1};
+    c1 *= c2; // (1 + 2i)(3 - i) = 5 + 5i
+    cout << c1.real() << "+" << c1.imag() << "i" << endl;
+
+    ComplexArray a {{1, 2}, {3, -1}, {0, 1}};
+    ComplexArray b {{3, -1}, {3, -1}, {0, 1}};
+    ComplexArray p = a;
+    p *= b;
+    ComplexArray q = a;
+    q.conj_mul(a); // z * conj(z) = |z|^2 with no imag part
+    double mag[3];
+    a.magnitude(mag);
+    for (int i = 0; i != a.get_size(); i++) {
+        cout << p.get(i).real() << "+" << p.get(i).imag() << "i, " << q.get(i).real() << "+" << q.get(i).imag() << "i, |a| = " << mag[i] << endl;
+    }
+}
+
+// element-wise multiply of millions of samples: an array of Complex3 (re,im interleaved, one at a time thru operator*=)
+// vs ComplexArray with the plain loops and with the simd kernels
+void complex_array_benchmark() {
+    cout << "==>>complex_array_benchmark" << endl;
+    using namespace chrono;
+    const int len = 2'000'000;
+    const int rounds = 20;
+
+    unique_ptr<Complex3[]> aos_a {new Complex3[len]};
+    unique_ptr<Complex3[]> aos_b {new Complex3[len]};
+    unique_ptr<Complex3[]> aos_out {new Complex3[len]};
+    ComplexArray soa_a(len);
+    ComplexArray soa_b(len);
+    for (int i = 0; i != len; i++) {
+        double r = (i % 7) * 0.25, m = (i % 5) * -0.5;
+        aos_a[i] = Complex3 {r, m};
+        aos_b[i] = Complex3 {m, r};
+        soa_a.set(i, r, m);
+        soa_b.set(i, m, r);
+    }
+
+    auto time_it = [&](const string &name, auto work) {
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            work();
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, nano>(t2 - t1).count() / rounds / len << " ns/element" << endl;
+    };
+
+    ComplexArray out(len);
+    time_it("Complex3-array *=", [&] {
+        for (int i = 0; i != len; i++) {
+            Complex3 t {aos_a[i].real(), aos_a[i].imag()};
+            t *= aos_b[i];
+            aos_out[i] = t;
+        }
+    });
+    bool was = ComplexArray::use_simd(false);
+    time_it(string("ComplexArray mul ") + ComplexArray::simd_name(), [&] { mul(soa_a, soa_b, out); });
+    ComplexArray::use_simd(was);
+    time_it(string("ComplexArray mul ") + ComplexArray::simd_name(), [&] { mul(soa_a, soa_b, out); });
+    cout << "out[6] = " << out.get(6).real() << "+" << out.get(6).imag() << "i" << endl;
+}
+
+// a tone that goes round 3 times in 16 samples shows up in bin 3 (and in bin 13 = -3, its mirror)
+void fft_example() {
+    cout << "==>>fft_example" << endl;
+    const int n = 16;
+    ComplexArray signal(n);
+    double samples[n];
+    for (int i = 0; i != n; i++) {
+        samples[i] = cos(2 * numbers::pi * 3 * i / n);
+        signal.set(i, samples[i], 0);
+    }
+    fft::forward(signal);
+    for (int k = 0; k != n; k++) {
+        cout << round(signal.get(k).real() * 1000) / 1000 + 0.0 << " ";
+    }
+    cout << endl;
+
+    // the real path computes the same bins 0..n/2 (the others are conjugates of these)
+    ComplexArray bins = fft::forward_real(samples, n);
+    cout << "bin 3 = " << bins.get(3).real() << " - bins: " << bins.get_size() << endl;
+
+    fft::inverse(signal);
+    cout << "back: " << signal.get(0).real() << ", " << signal.get(1).real() << " - plans cached: " << fft::cached_plans() << endl;
+}
+
+// the transforms checked against the textbook O(n^2) dft, for every size up to 1024 (so both an even and an odd number of
+// radix-4 passes, and the radix-2 one). The error grows with log2(n), 1e-9 leaves plenty of room
+void fft_vs_dft() {
+    cout << "==>>fft_vs_dft" << endl;
+    double worst = 0;
+    for (int n = 2; n <= 1024; n *= 2) {
+        vector<double> re(n), im(n);
+        for (int i = 0; i != n; i++) {
+            re[i] = sin(i * 0.37) + (i % 5) * 0.2;
+            im[i] = cos(i * 0.11) - (i % 3) * 0.3;
+        }
+        // the dft of the complex input, and of its real part alone (what forward_real has to match on bins 0..n/2)
+        vector<double> dre(n), dim(n), rre(n), rim(n);
+        for (int k = 0; k != n; k++) {
+            for (int i = 0; i != n; i++) {
+                double angle = -2 * numbers::pi * (static_cast<long>(k) * i % n) / n;
+                dre[k] += re[i] * cos(angle) - im[i] * sin(angle);
+                dim[k] += re[i] * sin(angle) + im[i] * cos(angle);
+                rre[k] += re[i] * cos(angle);
+                rim[k] += re[i] * sin(angle);
+            }
+        }
+
+        ComplexArray a(n);
+        for (int i = 0; i != n; i++) {
+            a.set(i, re[i], im[i]);
+        }
+        fft::forward(a);
+        for (int k = 0; k != n; k++) {
+            worst = max(worst, abs(a.get(k).real() - dre[k]) + abs(a.get(k).imag() - dim[k]));
+        }
+        ComplexArray bins = fft::forward_real(re.data(), n);
+        for (int k = 0; k <= n / 2; k++) {
+            worst = max(worst, abs(bins.get(k).real() - rre[k]) + abs(bins.get(k).imag() - rim[k]));
+        }
+        // and back again
+        fft::inverse(a);
+        vector<double> back(n);
+        fft::inverse_real(bins, back.data(), n);
+        for (int i = 0; i != n; i++) {
+            worst = max(worst, abs(a.get(i).real() - re[i]) + abs(a.get(i).imag() - im[i]) + abs(back[i] - re[i]));
+        }
+    }
+    cout << "largest difference: " << worst << (worst < 1e-9 ? " - ok" : " - WRONG") << endl;
+}
+
+void fft_benchmark() {
+    cout << "==>>fft_benchmark" << endl;
+    using namespace chrono;
+    const int n = 1 << 20;
+    const int rounds = 10;
+    const int log2n = bit_width(static_cast<unsigned>(n)) - 1;
+    ComplexArray a(n);
+    vector<double> samples(n);
+    for (int i = 0; i != n; i++) {
+        samples[i] = sin(i * 0.01) + (i % 7) * 0.1;
+        a.set(i, samples[i], 0);
+    }
+
+    auto time_it = [&](const string &name, auto work) {
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            work();
+        }
+        auto t2 = high_resolution_clock::now();
+        double ms = duration<double, milli>(t2 - t1).count() / rounds;
+        // the usual fft 'flops' figure is 5 n log2(n) per transform (for the real one too, so the two compare), 2 transforms
+        cout << name << ": " << ms << " ms (" << 2 * 5.0 * n * log2n / ms / 1e6 << " GFLOP/s)" << endl;
+    };
+
+    time_it("complex forward+inverse", [&] {
+        fft::forward(a);
+        fft::inverse(a);
+    });
+    time_it("real forward+inverse", [&] {
+        ComplexArray bins = fft::forward_real(samples.data(), n);
+        fft::inverse_real(bins, samples.data(), n);
+    });
+    cout << "round trip: " << a.get(100).real() << " - " << samples[100] << endl;
+}
+
+// the views of riemann work on a Vector3 as well (it hands out its buffer thru begin/end): no Vector3 is made for any of them
+void vector3_views() {
+    cout << "vector3_views" << endl;
+    Vector3 v {1, 2, 3, 4, 5, 6, 7, 8};
+    for (double d : reversed(v)) {
+        cout << d << ", ";
+    }
+    cout << endl;
+    auto evens = strided(v, 1, 4, 2);
+    for (double &d : evens) {
+        d *= 10;
+    }
+    auto tail = slice(v, 4, 4);
+    cout << "v[3] = " << v[3] << " - tail[1] = " << tail[1] << " - tail size: " << tail.get_size() << endl;
+}
+
 int main() {
     add_complex_nums();
     struct_copy_assignment();
@@ -151,6 +389,14 @@ int main() {
     Vector3 v = copy_vs_move();
     cout << "should be 7: " << v.get_size() << " - should be 17: "<< v[0] << endl;
     vector_iteration();
+    vector3_views();
+    expression_templates();
+    arena_vectors();
+    complex_arrays();
+    complex_array_benchmark();
+    fft_example();
+    fft_vs_dft();
+    fft_benchmark();
 
     return 0;
 }
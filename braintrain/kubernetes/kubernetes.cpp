@@ -6,21 +6,22 @@
 #include <numeric>
 #include <random>
 #include <valarray>
+#include <functional>
+#include "../common/headers/Symbol.h"
 
 using namespace std;
 
 struct Book {
-    string title;
+    Symbol title;
     int pages = 0;
 
-    // instead of passing name by ref (const &name), Clang-Tidy suggested passing by value and 'move'
-    Book(string title, int pages) : title{move(title)}, pages{pages} {}
+    Book(string_view title, int pages) : title{title}, pages{pages} {}
 
     bool operator==(const Book &other) const {
         return title == other.title;
     }
 
-    [[nodiscard]] string summary() const { return title + "/" + to_string(pages); } // not much of a summary
+    [[nodiscard]] string summary() const { return title.str() + "/" + to_string(pages); } // not much of a summary
 };
 
 bool operator<(const Book &first, const Book &second) {
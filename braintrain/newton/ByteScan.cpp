@@ -0,0 +1,298 @@
+#include <algorithm>
+#include "headers/ByteScan.h"
+
+#ifdef BRAINTRAIN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace bytescan {
+namespace { // the kernels are implementation details: only the dispatching functions at the bottom are exported
+
+    // one table of function pointers per instruction set: one indirect call per buffer (not per byte)
+    struct Kernels {
+        size_t (*count)(const char *, size_t, char);
+        size_t (*find_first)(const char *, size_t, char);
+        size_t (*find_last)(const char *, size_t, char);
+        size_t (*count_any)(const char *, size_t, const ByteSet &);
+    };
+
+    constexpr size_t npos = string_view::npos;
+
+    // scalar kernels: also used for the tails the vector loops leave behind
+    size_t count_scalar(const char *p, size_t n, char c) {
+        size_t total = 0;
+        for (size_t i = 0; i != n; ++i) {
+            total += p[i] == c; // no branch: a compare and an add
+        }
+        return total;
+    }
+
+    size_t find_first_scalar(const char *p, size_t n, char c) {
+        for (size_t i = 0; i != n; ++i) {
+            if (p[i] == c) {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    size_t find_last_scalar(const char *p, size_t n, char c) {
+        for (size_t i = n; i != 0; --i) {
+            if (p[i - 1] == c) {
+                return i - 1;
+            }
+        }
+        return npos;
+    }
+
+    size_t count_any_scalar(const char *p, size_t n, const ByteSet &set) {
+        size_t total = 0;
+        for (size_t i = 0; i != n; ++i) {
+            total += set.contains(static_cast<unsigned char>(p[i]));
+        }
+        return total;
+    }
+
+#ifdef BRAINTRAIN_X86
+    // counting: a compare gives 0xff (-1) in every matching byte, so subtracting it adds 1 to a per-byte counter. The byte
+    // counters overflow after 255 rounds, so every 255 vectors they are summed up (psadbw against 0 adds 8 bytes at a time)
+    // and reset. That is one compare and one subtract per vector and no movemask/popcount in the loop
+    constexpr size_t max_rounds = 255;
+
+    __attribute__((target("sse2")))
+    size_t sum_bytes128(__m128i counters) {
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        // a lane adds up at most 8 * 255: the low 16 bits of each of the two 64-bit lanes hold it all
+        return static_cast<size_t>(_mm_extract_epi16(sums, 0) + _mm_extract_epi16(sums, 4));
+    }
+
+    __attribute__((target("sse2")))
+    size_t count_sse2(const char *p, size_t n, char c) {
+        const __m128i needle = _mm_set1_epi8(c);
+        size_t total = 0, i = 0;
+        while (n - i >= 16) {
+            size_t rounds = std::min((n - i) / 16, max_rounds);
+            __m128i counters = _mm_setzero_si128();
+            for (size_t r = 0; r != rounds; ++r, i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(v, needle));
+            }
+            total += sum_bytes128(counters);
+        }
+        return total + count_scalar(p + i, n - i, c);
+    }
+
+    __attribute__((target("sse2")))
+    size_t find_first_sse2(const char *p, size_t n, char c) {
+        const __m128i needle = _mm_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        size_t at = find_first_scalar(p + i, n - i, c);
+        return at == npos ? npos : i + at;
+    }
+
+    // from the back: whole vectors first, then the few bytes at the front that do not make a vector
+    __attribute__((target("sse2")))
+    size_t find_last_sse2(const char *p, size_t n, char c) {
+        const __m128i needle = _mm_set1_epi8(c);
+        size_t i = n;
+        for (; i >= 16; i -= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i - 16));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+            if (mask) {
+                return i - 16 + (31 - __builtin_clz(mask));
+            }
+        }
+        return find_last_scalar(p, i, c);
+    }
+
+    __attribute__((target("sse2")))
+    size_t count_any_sse2(const char *p, size_t n, const ByteSet &set) {
+        if (set.member_count < 0) {
+            return count_any_scalar(p, n, set);
+        }
+        __m128i needles[8];
+        for (int m = 0; m != set.member_count; ++m) {
+            needles[m] = _mm_set1_epi8(static_cast<char>(set.members[m]));
+        }
+        size_t total = 0, i = 0;
+        while (n - i >= 16) {
+            size_t rounds = std::min((n - i) / 16, max_rounds);
+            __m128i counters = _mm_setzero_si128();
+            for (size_t r = 0; r != rounds; ++r, i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                __m128i hit = _mm_setzero_si128();
+                for (int m = 0; m != set.member_count; ++m) {
+                    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[m]));
+                }
+                counters = _mm_sub_epi8(counters, hit);
+            }
+            total += sum_bytes128(counters);
+        }
+        return total + count_any_scalar(p + i, n - i, set);
+    }
+
+    __attribute__((target("avx2")))
+    size_t sum_bytes256(__m256i counters) {
+        __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+        return static_cast<size_t>(_mm256_extract_epi16(sums, 0) + _mm256_extract_epi16(sums, 4) +
+                                   _mm256_extract_epi16(sums, 8) + _mm256_extract_epi16(sums, 12));
+    }
+
+    __attribute__((target("avx2")))
+    size_t count_avx2(const char *p, size_t n, char c) {
+        const __m256i needle = _mm256_set1_epi8(c);
+        size_t total = 0, i = 0;
+        while (n - i >= 32) {
+            size_t rounds = std::min((n - i) / 32, max_rounds);
+            __m256i counters = _mm256_setzero_si256();
+            for (size_t r = 0; r != rounds; ++r, i += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(v, needle));
+            }
+            total += sum_bytes256(counters);
+        }
+        return total + count_scalar(p + i, n - i, c);
+    }
+
+    __attribute__((target("avx2")))
+    size_t find_first_avx2(const char *p, size_t n, char c) {
+        const __m256i needle = _mm256_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        size_t at = find_first_scalar(p + i, n - i, c);
+        return at == npos ? npos : i + at;
+    }
+
+    __attribute__((target("avx2")))
+    size_t find_last_avx2(const char *p, size_t n, char c) {
+        const __m256i needle = _mm256_set1_epi8(c);
+        size_t i = n;
+        for (; i >= 32; i -= 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i - 32));
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+            if (mask) {
+                return i - 32 + (31 - __builtin_clz(mask));
+            }
+        }
+        return find_last_scalar(p, i, c);
+    }
+
+    // any set at the same cost whatever its size: vpshufb looks up the low nibble of every byte in the two
+    // 16-entry tables (a byte's row), the high nibble picks the table and the bit of the row
+    __attribute__((target("avx2")))
+    size_t count_any_avx2(const char *p, size_t n, const ByteSet &set) {
+        const __m256i low_half = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.low_half)));
+        const __m256i high_half = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(set.high_half)));
+        // 1 << (h % 8) for h = 0..15
+        const __m256i bit_of = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        const __m256i seven = _mm256_set1_epi8(7);
+        const __m256i one = _mm256_set1_epi8(1);
+        size_t total = 0, i = 0;
+        while (n - i >= 32) {
+            size_t rounds = std::min((n - i) / 32, max_rounds);
+            __m256i counters = _mm256_setzero_si256();
+            for (size_t r = 0; r != rounds; ++r, i += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+                __m256i lo = _mm256_and_si256(v, nibble);
+                __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+                __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low_half, lo), _mm256_shuffle_epi8(high_half, lo),
+                                                 _mm256_cmpgt_epi8(hi, seven));
+                __m256i hit = _mm256_and_si256(row, _mm256_shuffle_epi8(bit_of, hi));
+                counters = _mm256_add_epi8(counters, _mm256_min_epu8(hit, one)); // the bit -> 1, no bit -> 0
+            }
+            total += sum_bytes256(counters);
+        }
+        return total + count_any_scalar(p + i, n - i, set);
+    }
+#endif
+
+    cpu::Dispatch<Kernels> &dispatch() {
+        static cpu::Dispatch<Kernels> d {
+                {Isa::scalar, {count_scalar, find_first_scalar, find_last_scalar, count_any_scalar}},
+#ifdef BRAINTRAIN_X86
+                {Isa::sse2, {count_sse2, find_first_sse2, find_last_sse2, count_any_sse2}},
+                {Isa::avx2, {count_avx2, find_first_avx2, find_last_avx2, count_any_avx2}},
+#endif
+        };
+        return d;
+    }
+}
+
+    ByteSet::ByteSet(string_view set) {
+        for (char c : set) {
+            auto b = static_cast<unsigned char>(c);
+            if (contains(b)) {
+                continue; // a repeated member
+            }
+            bits[b >> 6] |= uint64_t {1} << (b & 63);
+            uint8_t &row = (b >> 4) < 8 ? low_half[b & 0x0f] : high_half[b & 0x0f];
+            row |= static_cast<uint8_t>(1u << ((b >> 4) & 7));
+            if (member_count >= 0 && member_count < 8) {
+                members[member_count++] = b;
+            } else {
+                member_count = -1;
+            }
+        }
+    }
+
+    Isa active_isa() noexcept {
+        return dispatch().active();
+    }
+
+    Isa use_isa(Isa isa) noexcept {
+        return dispatch().use(isa);
+    }
+
+    const char *isa_name(Isa isa) noexcept {
+        return cpu::isa_name(isa);
+    }
+
+    size_t count(const char *p, size_t n, char c) {
+        return n ? dispatch().kernels().count(p, n, c) : 0;
+    }
+
+    size_t count(string_view s, char c) {
+        return count(s.data(), s.size(), c);
+    }
+
+    size_t find_first(const char *p, size_t n, char c) {
+        return n ? dispatch().kernels().find_first(p, n, c) : npos;
+    }
+
+    size_t find_first(string_view s, char c) {
+        return find_first(s.data(), s.size(), c);
+    }
+
+    size_t find_last(const char *p, size_t n, char c) {
+        return n ? dispatch().kernels().find_last(p, n, c) : npos;
+    }
+
+    size_t find_last(string_view s, char c) {
+        return find_last(s.data(), s.size(), c);
+    }
+
+    size_t count_any(const char *p, size_t n, const ByteSet &set) {
+        return n ? dispatch().kernels().count_any(p, n, set) : 0;
+    }
+
+    size_t count_any(string_view s, const ByteSet &set) {
+        return count_any(s.data(), s.size(), set);
+    }
+}
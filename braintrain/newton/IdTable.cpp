@@ -0,0 +1,89 @@
+#include "headers/IdTable.h"
+
+using namespace std;
+
+IdTable::IdTable(const IdTable &t)
+        : strings {t.strings}, ssn_codes {t.ssn_codes}, age_column {t.age_column}, tags {t.tags}, payloads {t.payloads} {
+    codes.reserve(strings.size());
+    for (uint32_t code = 0; code != strings.size(); code++) {
+        codes.emplace(strings[code], code);
+    }
+}
+
+IdTable &IdTable::operator=(const IdTable &t) {
+    if (&t != this) {
+        *this = IdTable {t}; // copy first: if it throws this table is untouched
+    }
+    return *this;
+}
+
+uint32_t IdTable::intern(string_view s) {
+    auto found = codes.find(s);
+    if (found != codes.end()) {
+        return found->second;
+    }
+    auto code = static_cast<uint32_t>(strings.size());
+    const string &stored = strings.emplace_back(s);
+    codes.emplace(stored, code); // the key views the copy in strings, not the caller's string
+    return code;
+}
+
+void IdTable::push_back(const Id &id) {
+    uint32_t code = intern(id.ssn);
+    // visit turns the variant into the tag and the 8-byte payload
+    auto [tag, payload] = visit([](auto v) -> pair<Kind, uint64_t> {
+        using T = decltype(v);
+        if constexpr (is_same_v<T, bool>) {
+            return {Kind::flag, v ? 1u : 0u};
+        } else if constexpr (is_same_v<T, int>) {
+            return {Kind::number, static_cast<uint64_t>(static_cast<int64_t>(v))};
+        } else {
+            return {Kind::pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v))};
+        }
+    }, id.id_variant);
+    ssn_codes.push_back(code);
+    age_column.push_back(id.age);
+    tags.push_back(tag);
+    payloads.push_back(payload);
+}
+
+void IdTable::reserve(int n) {
+    ssn_codes.reserve(n);
+    age_column.reserve(n);
+    tags.reserve(n);
+    payloads.reserve(n);
+}
+
+long IdTable::bytes() const {
+    long total = size() * static_cast<long>(sizeof(uint32_t) + sizeof(int) + sizeof(Kind) + sizeof(uint64_t));
+    for (const string &s : strings) {
+        total += sizeof(string) + (s.capacity() > 15 ? s.capacity() + 1 : 0); // short strings stay inside the object
+    }
+    return total;
+}
+
+variant<bool, int, double *> IdTable::id_variant(int r) const {
+    switch (tags[r]) {
+        case Kind::flag:
+            return decode<bool>(payloads[r]);
+        case Kind::number:
+            return decode<int>(payloads[r]);
+        case Kind::pointer:
+            return decode<double *>(payloads[r]);
+    }
+    return false;
+}
+
+Id IdTable::row(int r) const {
+    return Id {string(ssn(r)), age(r), id_variant(r)};
+}
+
+IdTable::Rows IdTable::where_ssn(string_view s, const Rows *within) const {
+    auto found = codes.find(s);
+    if (found == codes.end()) {
+        return {};
+    }
+    uint32_t code = found->second;
+    const uint32_t *c = ssn_codes.data();
+    return filter(size(), within, [&](int r) { return c[r] == code; });
+}
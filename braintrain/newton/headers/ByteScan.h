@@ -0,0 +1,59 @@
+#ifndef BRAINTRAIN_BYTESCAN_H
+#define BRAINTRAIN_BYTESCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "../../common/headers/Dispatch.h"
+
+// counting and searching bytes 16 (sse2) or 32 (avx2) at a time instead of one. The bytes the vector loop leaves over at
+// the end go thru the scalar kernel. There are no avx-512 kernels: an avx-512 cpu runs the avx2 ones.
+// Everything works on (pointer, length) or string_view: no NUL is needed and NULs in the data are just bytes
+namespace bytescan {
+    using Isa = cpu::Isa;
+
+    Isa active_isa() noexcept;
+
+    // force a narrower instruction set (for benchmarking); clamped down to what the cpu supports and there are kernels
+    // for. Safe while other threads are scanning
+    Isa use_isa(Isa) noexcept;
+
+    const char *isa_name(Isa) noexcept;
+
+    // a set of bytes to look for (delimiters: ",;\t\n" for example). Building it fills the lookup tables the kernels use,
+    // so build it once and reuse it for every buffer
+    struct ByteSet {
+        uint64_t bits[4] {}; // bit b is set when byte b is in the set (the scalar kernel)
+        // avx2: the bytes with low nibble l and high nibble h are in the set when bit (h % 8) of low_half[l] (h < 8) or of
+        // high_half[l] (h >= 8) is set; vpshufb looks up 32 low nibbles at once
+        uint8_t low_half[16] {};
+        uint8_t high_half[16] {};
+        // sse2 has no byte shuffle: sets of up to 8 members are compared one member at a time, bigger ones go scalar
+        uint8_t members[8] {};
+        int member_count = 0; // -1: more than 8 members
+
+        explicit ByteSet(std::string_view);
+
+        [[nodiscard]] bool contains(unsigned char b) const noexcept { return bits[b >> 6] >> (b & 63) & 1; }
+    };
+
+    std::size_t count(const char *, std::size_t, char);
+
+    std::size_t count(std::string_view, char);
+
+    // the index of the first/last occurrence, string_view::npos when there is none
+    std::size_t find_first(const char *, std::size_t, char);
+
+    std::size_t find_first(std::string_view, char);
+
+    std::size_t find_last(const char *, std::size_t, char);
+
+    std::size_t find_last(std::string_view, char);
+
+    // how many bytes are in the set
+    std::size_t count_any(const char *, std::size_t, const ByteSet &);
+
+    std::size_t count_any(std::string_view, const ByteSet &);
+}
+
+#endif //BRAINTRAIN_BYTESCAN_H
@@ -0,0 +1,15 @@
+#ifndef BRAINTRAIN_ID_H
+#define BRAINTRAIN_ID_H
+
+#include <string>
+#include <variant>
+
+using namespace std;
+
+struct Id {
+    string ssn;
+    int age;
+    variant<bool, int, double*>  id_variant; // can hold any type (c++17) - we can use tagged 'union' in c++14 and below
+};
+
+#endif //BRAINTRAIN_ID_H
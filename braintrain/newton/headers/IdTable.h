@@ -0,0 +1,136 @@
+#ifndef BRAINTRAIN_IDTABLE_H
+#define BRAINTRAIN_IDTABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Id.h"
+
+// a vector<Id> is an array of 48-byte records (a 32-byte string, an int, a 16-byte variant) and every ssn longer than the
+// small string buffer is a pointer to somewhere else on the heap. A scan that only wants the ages still drags the other
+// 44 bytes of every record thru the cache.
+// IdTable stores the same records column by column: the ages are one int array, the ssns are 4-byte codes into a
+// dictionary that holds each distinct string once, and the variants are a 1-byte tag array plus an 8-byte payload array.
+// A scan touches only the columns it asks for (4 bytes a record for the ages) and an ssn compare is an int compare
+class IdTable {
+public:
+    using Rows = vector<int>; // row numbers, ascending: what the where_ functions return and take to narrow down
+
+    // the variant alternatives in index() order: the tag column holds these
+    enum class Kind : uint8_t {
+        flag, number, pointer
+    };
+private:
+    // the dictionary: every distinct ssn once, looked up by value when a record is added or a filter asks for it. The
+    // string_view keys point into strings, which is a deque so they never move as it grows
+    deque<string> strings;
+    unordered_map<string_view, uint32_t> codes;
+
+    vector<uint32_t> ssn_codes;
+    vector<int> age_column;
+    vector<Kind> tags;
+    vector<uint64_t> payloads; // the bool (0/1), the int (sign extended) or the pointer, by the tag of the same row
+
+    uint32_t intern(string_view);
+
+    template<typename Test>
+    static Rows filter(int n, const Rows *within, Test test) {
+        Rows out;
+        if (within) {
+            for (int r : *within) {
+                if (test(r)) {
+                    out.push_back(r);
+                }
+            }
+        } else {
+            for (int r = 0; r != n; r++) {
+                if (test(r)) {
+                    out.push_back(r);
+                }
+            }
+        }
+        return out;
+    }
+public:
+    IdTable() = default;
+
+    // the keys of codes view this table's own strings: a copy rebuilds the index over its copied strings (an implicit
+    // copy would keep viewing the source's, which dangle once the source is gone)
+    IdTable(const IdTable &);
+
+    IdTable &operator=(const IdTable &);
+
+    // a moved deque hands over its blocks, the strings stay where they are and so do the keys viewing them
+    IdTable(IdTable &&) = default;
+
+    IdTable &operator=(IdTable &&) = default;
+
+    void push_back(const Id &);
+
+    void reserve(int);
+
+    [[nodiscard]] int size() const { return static_cast<int>(age_column.size()); }
+
+    [[nodiscard]] int distinct_ssns() const { return static_cast<int>(strings.size()); }
+
+    // the columns plus the dictionary strings (not counting the hash index)
+    [[nodiscard]] long bytes() const;
+
+    // one record put back together (copies the ssn)
+    [[nodiscard]] Id row(int) const;
+
+    [[nodiscard]] string_view ssn(int r) const { return strings[ssn_codes[r]]; }
+
+    [[nodiscard]] int age(int r) const { return age_column[r]; }
+
+    [[nodiscard]] Kind kind(int r) const { return tags[r]; }
+
+    [[nodiscard]] variant<bool, int, double *> id_variant(int) const;
+
+    // the raw columns for scans the where_ functions do not cover
+    [[nodiscard]] span<const int> ages() const { return age_column; }
+
+    [[nodiscard]] span<const Kind> kinds() const { return tags; }
+
+    // reads only the age column (of the rows in within when it is given)
+    template<typename Pred>
+    Rows where_age(Pred pred, const Rows *within = nullptr) const {
+        const int *a = age_column.data();
+        return filter(size(), within, [&](int r) { return pred(a[r]); });
+    }
+
+    // one dictionary lookup, then a scan of the 4-byte codes: an ssn that was never added matches nothing without a scan
+    Rows where_ssn(string_view, const Rows *within = nullptr) const;
+
+    // reads the tag column, and the payload of the rows whose variant holds a T: where_variant<int>([](int v) {...})
+    template<typename T, typename Pred>
+    Rows where_variant(Pred pred, const Rows *within = nullptr) const {
+        constexpr Kind wanted = kind_of<T>();
+        const Kind *t = tags.data();
+        const uint64_t *p = payloads.data();
+        return filter(size(), within, [&](int r) { return t[r] == wanted && pred(decode<T>(p[r])); });
+    }
+
+    template<typename T>
+    static constexpr Kind kind_of() {
+        static_assert(is_same_v<T, bool> || is_same_v<T, int> || is_same_v<T, double *>, "not an Id variant alternative");
+        return is_same_v<T, bool> ? Kind::flag : is_same_v<T, int> ? Kind::number : Kind::pointer;
+    }
+
+    template<typename T>
+    static T decode(uint64_t payload) {
+        if constexpr (is_same_v<T, bool>) {
+            return payload != 0;
+        } else if constexpr (is_same_v<T, int>) {
+            return static_cast<int>(static_cast<int64_t>(payload));
+        } else {
+            return reinterpret_cast<double *>(static_cast<uintptr_t>(payload));
+        }
+    }
+};
+
+#endif //BRAINTRAIN_IDTABLE_H
@@ -0,0 +1,112 @@
+#ifndef BRAINTRAIN_LOOKUP_H
+#define BRAINTRAIN_LOOKUP_H
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// turns a constexpr function into a table the compiler fills in: when the function only ever sees a small domain, a call
+// at run time becomes one load (or two loads and an fma when interpolating) instead of a loop.
+// Make the table constexpr (or static constexpr in a function) so it is computed at compile time and sits in .rodata; a
+// table that is not constexpr is filled at run time like any other array
+
+// base^exp by squaring: O(log exp) multiplications instead of the exp - 1 of the loop in fct1. A negative exponent is
+// 1 / base^-exp for floating point types and an error for integers. The rounding differs from the loop in the last bit
+// or so (the products are grouped differently)
+template<typename T>
+constexpr T power(T base, int exp) {
+    if (exp < 0) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return T {1} / power(base, -exp);
+        } else {
+            throw std::domain_error("negative exponent of an integer power");
+        }
+    }
+    T result {1};
+    while (exp) {
+        if (exp & 1) {
+            result *= base;
+        }
+        exp >>= 1;
+        if (exp) {
+            base *= base;
+        }
+    }
+    return result;
+}
+
+// table[i] = f(first + i) for the N integers from first on
+template<std::size_t N, typename F>
+constexpr auto make_table(F f, int first = 0) {
+    using R = std::invoke_result_t<F, int>;
+    std::array<R, N> table {};
+    for (std::size_t i = 0; i != N; ++i) {
+        table[i] = f(first + static_cast<int>(i));
+    }
+    return table;
+}
+
+// N evenly spaced samples of f over [lo, hi] (both ends included). operator() interpolates linearly between the two
+// nearest samples and clamps outside [lo, hi]; nearest() rounds to a sample. The error of the interpolation is at most
+// h^2 / 8 * max|f''| with h = (hi - lo) / (N - 1), so N picks the accuracy
+template<typename T, std::size_t N>
+class SampledTable {
+    static_assert(N >= 2, "a sampled table needs both ends");
+private:
+    std::array<T, N> samples {};
+    double lo {};
+    double hi {};
+    double scale {}; // samples per unit of x: (N - 1) / (hi - lo)
+public:
+    template<typename F>
+    constexpr SampledTable(F f, double low, double high): lo {low}, hi {high}, scale {(N - 1) / (high - low)} {
+        if (!(low < high)) {
+            throw std::invalid_argument("a sampled table needs low < high");
+        }
+        for (std::size_t i = 0; i != N; ++i) {
+            samples[i] = f(low + (high - low) * static_cast<double>(i) / (N - 1));
+        }
+    }
+
+    constexpr T operator()(double x) const {
+        if (!(x > lo)) { // also catches NaN
+            return samples[0];
+        }
+        if (x >= hi) {
+            return samples[N - 1];
+        }
+        double pos = (x - lo) * scale;
+        auto i = static_cast<std::size_t>(pos);
+        if (i >= N - 1) { // x just below hi can round up to the last sample
+            return samples[N - 1];
+        }
+        double frac = pos - static_cast<double>(i);
+        return samples[i] + (samples[i + 1] - samples[i]) * frac;
+    }
+
+    [[nodiscard]] constexpr T nearest(double x) const {
+        if (!(x > lo)) {
+            return samples[0];
+        }
+        if (x >= hi) {
+            return samples[N - 1];
+        }
+        return samples[static_cast<std::size_t>((x - lo) * scale + 0.5)];
+    }
+
+    [[nodiscard]] constexpr const std::array<T, N> &values() const { return samples; }
+
+    [[nodiscard]] constexpr double low() const { return lo; }
+
+    [[nodiscard]] constexpr double high() const { return hi; }
+};
+
+// the return type of f picks T: tabulate<257>(f, 0, 1)
+template<std::size_t N, typename F>
+constexpr auto tabulate(F f, double low, double high) {
+    return SampledTable<std::invoke_result_t<F, double>, N>(f, low, high);
+}
+
+#endif //BRAINTRAIN_LOOKUP_H
@@ -1,15 +1,16 @@
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <string>
 #include <vector>
 #include <variant>
+#include "headers/ByteScan.h"
+#include "headers/Id.h"
+#include "headers/IdTable.h"
+#include "headers/Lookup.h"
 
 using namespace std;
 
-struct Id {
-    string ssn;
-    int age;
-    variant<bool, int, double*>  id_variant; // can hold any type (c++17) - we can use tagged 'union' in c++14 and below
-};
-
 void print_val(Id& id) {
     cout << "Id ssn is: " << id.ssn << endl;
     cout << "Id age is: " << id.age << endl;
@@ -20,6 +21,12 @@ void print_val(Id& id) {
  * it as arguments. In particular, it cannot modify non-local variables, but it can have loops and use its own local variables.
  */
 constexpr double fct1(int counter, double val) {
+    // val^counter by squaring (check Lookup.h): 4 multiplications for counter = 9 rather than 9 trips thru a loop
+    return counter > 0 ? power(val, counter) : 1;
+}
+
+// the loop fct1 used to be: the baseline for lookup_tables
+constexpr double fct1_loop(int counter, double val) {
     int c = 0;
     double res = 1;
     while (c < counter) {
@@ -29,11 +36,34 @@ constexpr double fct1(int counter, double val) {
     return res;
 }
 
-// find val occurrences in arr assuming it ends with '0'
+// a function that is slow to compute and only ever called on a small domain: the Newton iteration for a square root
+constexpr double newton_sqrt(double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    double r = x > 1 ? x : 1;
+    for (int i = 0; i != 64; i++) { // until it stops moving (a handful of steps once it is close, more from far away)
+        double next = 0.5 * (r + x / r);
+        if (next == r) {
+            break;
+        }
+        r = next;
+    }
+    return r;
+}
+
+// find val occurrences in arr assuming it ends with '\0' (the NUL char, not the digit '0')
 int count_c (const char* arr_ptr, char val) {
     if (arr_ptr == nullptr) {
         return 0;
     }
+    // strlen finds the end 16/32 bytes at a time (libc vectorizes it) and the count does the same (check ByteScan.h): two
+    // fast passes beat one pass that looks at every byte twice (is it the NUL? is it val?)
+    return static_cast<int>(bytescan::count(arr_ptr, strlen(arr_ptr), val));
+}
+
+// count_c one byte at a time the way it used to be: the baseline for delimiter_scan
+int count_c_bytewise(const char* arr_ptr, char val) {
     int count = 0;
     for (; *arr_ptr != 0; arr_ptr++) {
         if (*arr_ptr == val) {
@@ -43,6 +73,42 @@ int count_c (const char* arr_ptr, char val) {
     return count;
 }
 
+// a 64 MB log: count the lines and the field delimiters, and look for the one byte at either end (so the searches have to
+// go thru the whole log), with every kernel the cpu supports. The bytewise loop runs at about a byte per cycle; the vector kernels are limited by memory bandwidth
+void delimiter_scan() {
+    cout << "delimiter_scan" << endl;
+    using namespace chrono;
+    string log = "^";
+    const string line = "2024-01-01T00:00:00Z,INFO;worker-7\tjob finished in 42 ms\n";
+    while (log.size() < (64 << 20)) {
+        log += line;
+    }
+    log += '$';
+    auto time_it = [&](const string &name, auto scan) {
+        auto t1 = high_resolution_clock::now();
+        size_t result = scan();
+        auto t2 = high_resolution_clock::now();
+        double secs = duration<double>(t2 - t1).count();
+        cout << name << ": " << secs * 1000 << " ms, " << log.size() / secs / 1e9 << " GB/s (" << result << ")" << endl;
+    };
+    time_it("count_c bytewise", [&] { return count_c_bytewise(log.c_str(), '\n'); });
+    time_it("count_c", [&] { return count_c(log.c_str(), '\n'); });
+
+    bytescan::ByteSet delimiters {",;\t"};
+    bytescan::Isa best = bytescan::active_isa();
+    for (bytescan::Isa isa : {bytescan::Isa::scalar, bytescan::Isa::sse2, bytescan::Isa::avx2}) {
+        if (bytescan::use_isa(isa) != isa) {
+            break; // the cpu does not have it
+        }
+        string name = bytescan::isa_name(isa);
+        time_it("count " + name, [&] { return bytescan::count(log, '\n'); });
+        time_it("count_any " + name, [&] { return bytescan::count_any(log, delimiters); });
+        time_it("find_first " + name, [&] { return bytescan::find_first(log, '$'); });
+        time_it("find_last " + name, [&] { return bytescan::find_last(log, '^'); });
+    }
+    bytescan::use_isa(best);
+}
+
 void assign1() {
     Id id1;
     id1.ssn = "ssn1";
@@ -121,6 +187,107 @@ void init() {
     // int& r2 = 7; // error: assignment of ref b4 init
 }
 
+// the compiler runs fct1 and newton_sqrt and stores the results: at run time a call is a load (and an interpolation)
+void lookup_tables() {
+    cout << "lookup_tables" << endl;
+    using namespace chrono;
+    static constexpr auto powers = make_table<32>([](int n) { return fct1(n, 1.5); });
+    static_assert(powers[2] == 2.25);
+    static constexpr auto roots = tabulate<1025>(newton_sqrt, 1, 100);
+    static constexpr auto cubes = make_table<16>([](int n) { return power(n, 3); }, -8); // -8^3 .. 7^3
+    static_assert(cubes[0] == -512 && cubes[15] == 343);
+    cout << "1.5^10: " << powers[10] << " - sqrt(50): " << roots(50) << " (nearest sample " << roots.nearest(50)
+         << ", newton " << newton_sqrt(50) << ")" << endl;
+
+    const int rounds = 10'000'000;
+    auto time_it = [&](const string &name, auto f) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int i = 0; i != rounds; i++) {
+            s += f(i);
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, nano>(t2 - t1).count() / rounds << " ns/call (checksum " << s << ")" << endl;
+    };
+    // volatile: keeps the compiler from folding the loops away now that it can see every value
+    volatile double base = 1.5;
+    time_it("fct1 loop", [&](int i) { return fct1_loop(i & 31, base); });
+    time_it("fct1 squaring", [&](int i) { return fct1(i & 31, base); });
+    time_it("fct1 table", [&](int i) { return powers[i & 31]; });
+    time_it("newton_sqrt", [&](int i) { return newton_sqrt(1 + (i & 1023) * base * 0.06); });
+    time_it("sqrt table", [&](int i) { return roots(1 + (i & 1023) * base * 0.06); });
+}
+
+// 2M records with 50k distinct ssns, as a vector<Id> and as an IdTable. The queries read one or two fields: over the
+// vector every record is pulled thru the cache whole, over the table only those columns are
+void columnar_ids() {
+    cout << "columnar_ids" << endl;
+    using namespace chrono;
+    const int records = 2'000'000;
+    static double measurement = 0.5;
+    vector<Id> rows;
+    rows.reserve(records);
+    IdTable table;
+    table.reserve(records);
+    for (int i = 0; i != records; i++) {
+        Id id {"ssn-000-00-" + to_string(i % 50'000), 18 + i % 70, false};
+        switch (i % 3) {
+            case 0:
+                id.id_variant = i % 7 == 0;
+                break;
+            case 1:
+                id.id_variant = i % 1000;
+                break;
+            default:
+                id.id_variant = &measurement;
+        }
+        table.push_back(id);
+        rows.push_back(std::move(id));
+    }
+    long vector_bytes = records * static_cast<long>(sizeof(Id));
+    for (const Id &id : rows) {
+        vector_bytes += id.ssn.capacity() > 15 ? id.ssn.capacity() + 1 : 0; // the ssns too long for the string itself
+    }
+    cout << "vector<Id>: " << vector_bytes / (1 << 20) << " MB - IdTable: " << table.bytes() / (1 << 20) << " MB ("
+         << table.distinct_ssns() << " distinct ssns)" << endl;
+
+    auto time_it = [&](const string &name, auto query) {
+        auto t1 = high_resolution_clock::now();
+        size_t result = query();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, milli>(t2 - t1).count() << " ms (" << result << ")" << endl;
+    };
+    time_it("vector<Id> age > 60", [&] {
+        size_t n = 0;
+        for (const Id &id : rows) {
+            n += id.age > 60;
+        }
+        return n;
+    });
+    time_it("IdTable age > 60", [&] { return table.where_age([](int a) { return a > 60; }).size(); });
+    time_it("vector<Id> ssn == ssn-000-00-42", [&] {
+        size_t n = 0;
+        for (const Id &id : rows) {
+            n += id.ssn == "ssn-000-00-42";
+        }
+        return n;
+    });
+    time_it("IdTable ssn == ssn-000-00-42", [&] { return table.where_ssn("ssn-000-00-42").size(); });
+    time_it("vector<Id> int variant > 990 and age < 30", [&] {
+        size_t n = 0;
+        for (const Id &id : rows) {
+            n += holds_alternative<int>(id.id_variant) && get<int>(id.id_variant) > 990 && id.age < 30;
+        }
+        return n;
+    });
+    time_it("IdTable int variant > 990 and age < 30", [&] {
+        IdTable::Rows big = table.where_variant<int>([](int v) { return v > 990; });
+        return table.where_age([](int a) { return a < 30; }, &big).size(); // only the rows that passed the first test
+    });
+    Id back = table.row(4);
+    cout << "row 4: " << back.ssn << ", " << back.age << ", holds int: " << holds_alternative<int>(back.id_variant) << endl;
+}
+
 int main() {
     cout << sizeof(char) << endl;
     cout << 100'000'000 << endl;
@@ -171,7 +338,7 @@ int main() {
 
     int* int_val2 = nullptr;
 
-    char chars[] = {'a', 'b', 'x', 'd', 'x', '0'};
+    char chars[] = {'a', 'b', 'x', 'd', 'x', '\0'}; // '0' is the digit: count_c would run off the end looking for the NUL
     cout << count_c(chars, 'x') << endl;
 
     assign1();
@@ -182,6 +349,9 @@ int main() {
     cout << endl;
     init();
     cout << endl;
+    delimiter_scan();
+    lookup_tables();
+    columnar_ids();
 
     return 0;
 }
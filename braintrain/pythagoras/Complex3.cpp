@@ -18,6 +18,14 @@ Complex3& Complex3::operator+=(Complex3 c) {
     img += c.imag();
     return *this;
 }
+
+// (a + bi)(c + di) = (ac - bd) + (ad + bc)i. The real part is kept in a local since the imag part still needs the old one
+Complex3& Complex3::operator*=(Complex3 c) {
+    double r = rl * c.real() - img * c.imag();
+    img = rl * c.imag() + img * c.real();
+    rl = r;
+    return *this;
+}
 // B.S. says that this could be defined elsewhere but I got compile errors about having 3 args for the binary operator
 // so defined here it does not work with c1 + c2. I am missing some more twists in this sad api.
 Complex3 operator+ (Complex3 c1, Complex3 c2) { // passed by value so we can change in the func w/o affecting caller
@@ -1,16 +1,137 @@
 #include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 #include "headers/Container_Factory.h"
 #include "headers/Vector_Container.h"
 
 using namespace std;
 
+namespace {
+    struct Entry {
+        Container_Factory::Creator create;
+        Container_Factory::Pooled (*acquire)(initializer_list<double>); // nullptr: the type is not pooled
+    };
+
+    // the name -> type registry. Only the lookups by name come here, so a shared lock is plenty: registering is rare
+    struct Registry {
+        shared_mutex mtx;
+        unordered_map<string, Entry> entries;
+
+        Registry() {
+            entries[container_name(Container_Type::vector)] = {
+                    [](initializer_list<double> init) -> unique_ptr<Container1> { return make_unique<Vector_Container>(init); },
+                    &Container_Factory::acquire<Vector_Container>};
+        }
+
+        Entry find(const string &name) {
+            shared_lock lock {mtx};
+            auto it = entries.find(name);
+            if (it == entries.end()) {
+                throw invalid_argument("no container type registered as '" + name + "'");
+            }
+            return it->second;
+        }
+    };
+
+    // never deleted on purpose: a type may be looked up from the destructor of another static
+    Registry &registry() {
+        static Registry &r = *new Registry;
+        return r;
+    }
+}
+
+const char *container_name(Container_Type type) {
+    switch (type) {
+        case Container_Type::vector:
+            return "vector";
+    }
+    throw invalid_argument(to_string(static_cast<int>(type)));
+}
+
 unique_ptr<Container1> Container_Factory::createContainer(initializer_list<double>&& init, int&& type) {
-    // here we can potentially have a switch that return different implementations of Container 1 based on type (better be enum, etc.)
+    // the int is the old way of picking the type, it maps onto the enum
     switch (type) {
-        case 1:
-            return unique_ptr<Container1>(new Vector_Container(init));
+        case static_cast<int>(Container_Type::vector):
+            return create(Container_Type::vector, init);
         default:
             throw invalid_argument(to_string(type));
     }
+}
+
+unique_ptr<Container1> Container_Factory::create(const string &name, initializer_list<double> init) {
+    Entry e = registry().find(name);
+    tally().created++;
+    return e.create(init); // outside the lock: it allocates
+}
+
+unique_ptr<Container1> Container_Factory::create(Container_Type type, initializer_list<double> init) {
+    switch (type) {
+        case Container_Type::vector:
+            tally().created++;
+            return make_unique<Vector_Container>(init);
+    }
+    throw invalid_argument(to_string(static_cast<int>(type)));
+}
+
+Container_Factory::Pooled Container_Factory::acquire(const string &name, initializer_list<double> init) {
+    Entry e = registry().find(name);
+    if (e.acquire) {
+        return e.acquire(init);
+    }
+    tally().created++;
+    return Pooled(e.create(init).release(), Recycler {&discard});
+}
+
+Container_Factory::Pooled Container_Factory::acquire(Container_Type type, initializer_list<double> init) {
+    switch (type) {
+        case Container_Type::vector:
+            return acquire<Vector_Container>(init);
+    }
+    throw invalid_argument(to_string(static_cast<int>(type)));
+}
+
+void Container_Factory::register_type(const string &name, Creator create) {
+    add_type(name, create, nullptr);
+}
+
+void Container_Factory::add_type(const string &name, Creator create, Acquirer acquire) {
+    if (!create) {
+        throw invalid_argument("container type '" + name + "' registered without a creator");
+    }
+    Registry &r = registry();
+    unique_lock lock {r.mtx};
+    if (!r.entries.try_emplace(name, Entry {create, acquire}).second) {
+        throw invalid_argument("container type '" + name + "' is already registered");
+    }
+}
+
+bool Container_Factory::is_registered(const string &name) {
+    Registry &r = registry();
+    shared_lock lock {r.mtx};
+    return r.entries.contains(name);
+}
+
+void Container_Factory::set_pool_limit(size_t limit) {
+    pool_limit.store(limit, memory_order_relaxed);
+    for (Shelf *s = shelves; s; s = s->next) {
+        s->trim(limit);
+    }
+}
 
+Container_Factory::Stats Container_Factory::stats() {
+    Stats st = tally();
+    st.pooled = 0;
+    for (const Shelf *s = shelves; s; s = s->next) {
+        st.pooled += s->size();
+    }
+    return st;
+}
+
+void Container_Factory::drain() {
+    for (Shelf *s = shelves; s; s = s->next) {
+        s->trim(0);
+    }
 }
@@ -0,0 +1,23 @@
+#include <stdexcept>
+#include <string>
+#include "headers/Span_Container.h"
+
+Span_Container::Span_Container(double *first, int n) : items(first, n) {
+    if (n < 0) {
+        throw length_error("negative length: " + to_string(n));
+    }
+}
+
+Span_Container::Span_Container(span<double> s) : items(s) {}
+
+int Span_Container::length() const {
+    return static_cast<int>(items.size());
+}
+
+// throws like Vector::operator[] does so the two containers behave the same
+double &Span_Container::operator[](int i) {
+    if (i < 0 || i >= length()) {
+        throw out_of_range("index " + to_string(i) + " outside [0, " + to_string(length()) + ")");
+    }
+    return items[i];
+}
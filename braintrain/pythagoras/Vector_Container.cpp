@@ -1,8 +1,21 @@
+#include <algorithm>
 #include "headers/Container1.h"
 #include "headers/Vector_Container.h"
 
 Vector_Container::Vector_Container(initializer_list<double> init) : vec(init) {}
 
+Vector_Container::Vector_Container(int n) : vec(n) {
+    fill_n(vec.data(), n, 0.0); // Vector(int) leaves the doubles uninitialized
+}
+
+void Vector_Container::assign(initializer_list<double> init) {
+    if (static_cast<int>(init.size()) == vec.get_size()) {
+        copy(init.begin(), init.end(), vec.data());
+    } else {
+        vec = N::Vector(init);
+    }
+}
+
 int Vector_Container::length() const {
     return vec.get_size();
 }
@@ -17,7 +17,7 @@ public:
 
     Complex3& operator+=(Complex3 c);
 
-    Complex3& operator*=(Complex3 c1); // concrete class does not have to implement all header funcs
+    Complex3& operator*=(Complex3 c1); // a concrete class does not have to implement all header funcs (it used to not)
 };
 
 #endif //CPP_COMPLEX3_H
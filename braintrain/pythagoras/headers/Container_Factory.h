@@ -1,19 +1,231 @@
 #ifndef CPP_CONTAINER_FACTORY_H
 #define CPP_CONTAINER_FACTORY_H
 
+#include <atomic>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
 #include "Container1.h"
 
 using namespace std;
 
+// the built in container types. A registry key is a string so other types can be registered at runtime; the enum just
+// names the ones we ship (and replaces the magic int that createContainer takes)
+enum class Container_Type {
+    vector = 1
+};
+
+const char *container_name(Container_Type);
+
 class Container_Factory {
 public:
+    // builds a container from the values. A plain function pointer: the registry is looked up by name, the call itself
+    // should not go thru a std::function on top of that
+    using Creator = unique_ptr<Container1> (*)(initializer_list<double>);
+
+    // the deleter of a pooled container: instead of deleting it gives the container back to the pool of its type. The
+    // pool is picked when the container is handed out (a pointer to Pool<C>::release), so releasing is one indirect call
+    // and no lookup
+    struct Recycler {
+        void (*release)(Container1 *) noexcept = nullptr; // nullptr: the type is not pooled, just delete
+
+        void operator()(Container1 *c) const noexcept {
+            if (release) {
+                release(c);
+            } else {
+                delete c;
+            }
+        }
+    };
+
+    using Pooled = unique_ptr<Container1, Recycler>;
+
+    // counted per thread, like the pools themselves: a thread only ever sees its own
+    struct Stats {
+        long created = 0;  // new containers (pool was empty or the type is not pooled)
+        long reused = 0;   // handed out from the pool
+        long recycled = 0; // released into the pool
+        long freed = 0;    // released but deleted (pool full or type not pooled)
+        size_t pooled = 0; // sitting in this thread's pools right now
+    };
+
     // we could return naked pointer or ref to Container1 but that's discouraged because it leads to resource leaks if the
     // container is not deleted thru the pointer (one pitfall of c++)
     // according to B.S. Objects 'owned' by unique_ptr need no destructors as the compiler generates one for them that does what is needed
     // note that passing an Rvalue is not necessary but nice since it indicate the these params are not assignable (found this usage
     // in an example in Effective Modern C++
     static unique_ptr<Container1> createContainer(initializer_list<double>&&, int&&);
+
+    // a fresh container of a registered type; throws invalid_argument for a name nobody registered
+    static unique_ptr<Container1> create(const string &, initializer_list<double>);
+
+    static unique_ptr<Container1> create(Container_Type, initializer_list<double>);
+
+    // like create but the container comes from (and goes back to) the pool of its type. A pooled container with the same
+    // length is preferred since refilling it does not touch the allocator at all.
+    // By name it takes the registry's shared lock for the lookup; the enum and the template know the type at compile time
+    // and take no lock at all, use them in hot loops
+    static Pooled acquire(const string &, initializer_list<double>);
+
+    static Pooled acquire(Container_Type, initializer_list<double>);
+
+    template<typename C>
+    static Pooled acquire(initializer_list<double> init) {
+        if constexpr (poolable<C>) {
+            return Pool<C>::acquire(init);
+        } else {
+            tally().created++;
+            return Pooled(new C(init), Recycler {&discard});
+        }
+    }
+
+    // a type that is never pooled: acquire creates it and the Recycler deletes it
+    static void register_type(const string &, Creator);
+
+    // any Container1 that can be built from an initializer_list; it is pooled if it has an assign(initializer_list<double>)
+    template<typename C>
+    static void register_type(const string &name) {
+        add_type(name, [](initializer_list<double> init) -> unique_ptr<Container1> { return make_unique<C>(init); },
+                 &acquire<C>);
+    }
+
+    [[nodiscard]] static bool is_registered(const string &);
+
+    // the most containers kept per type and thread (default 64); the extras are deleted when released. The calling
+    // thread's pools are trimmed right away, another thread's pool of a type on its next release of that type
+    static void set_pool_limit(size_t);
+
+    static Stats stats();
+
+    // delete everything in the calling thread's pools
+    static void drain();
+
+private:
+    template<typename C>
+    static constexpr bool poolable = requires(C &c, initializer_list<double> init) { c.assign(init); };
+
+    using Acquirer = Pooled (*)(initializer_list<double>);
+
+    static void add_type(const string &, Creator, Acquirer);
+
+    // the Recycler of a type that is not pooled
+    static void discard(Container1 *c) noexcept {
+        delete c;
+        tally().freed++;
+    }
+
+    static inline atomic<size_t> pool_limit {64};
+
+    // this thread's counts (a function: a Stats member would need Stats complete before the class is)
+    static Stats &tally() noexcept {
+        thread_local Stats counts;
+        return counts;
+    }
+
+    // what drain, stats and set_pool_limit need from a pool without knowing its type. Every pool a thread has touched is
+    // on that thread's shelves list
+    struct Shelf {
+        Shelf *next = nullptr;
+
+        virtual size_t size() const = 0;
+
+        virtual void trim(size_t) = 0;
+
+        virtual ~Shelf() = default;
+    };
+
+    static inline thread_local Shelf *shelves = nullptr;
+
+    // the released containers of type C on one thread. Nothing is shared between threads, so there is no lock: acquiring
+    // is a pop and a refill, releasing a push. A container released on another thread than the one it came from just
+    // joins the pool of the releasing thread, and a thread's pool is deleted with the thread
+    template<typename C>
+    class Pool final : public Shelf {
+    public:
+        static Pooled acquire(initializer_list<double> init) {
+            Pool *p = mine();
+            if (!p || p->free.empty()) {
+                tally().created++;
+                return Pooled(new C(init), Recycler {&release});
+            }
+            auto &free = p->free;
+            // newest first (the most likely to still be in cache), and the same length if there is one. C is known here
+            // so length() is a direct call
+            auto pick = free.end() - 1;
+            for (auto it = free.rbegin(); it != free.rend(); ++it) {
+                if ((*it)->length() == static_cast<int>(init.size())) {
+                    pick = std::next(it).base();
+                    break;
+                }
+            }
+            iter_swap(pick, free.end() - 1);
+            unique_ptr<C> c = std::move(free.back());
+            free.pop_back();
+            c->assign(init); // may throw (a different length allocates): c is deleted and the pool is still fine
+            tally().reused++;
+            return Pooled(c.release(), Recycler {&release});
+        }
+
+        static void release(Container1 *c) noexcept {
+            unique_ptr<C> owned {static_cast<C *>(c)};
+            Pool *p = mine();
+            const size_t limit = pool_limit.load(memory_order_relaxed);
+            if (p) {
+                p->trim(limit); // the limit may have been lowered on another thread since this pool last grew
+            }
+            if (p && p->free.size() < limit) {
+                try {
+                    p->free.push_back(std::move(owned));
+                    tally().recycled++;
+                    return;
+                } catch (const bad_alloc &) {
+                    // the pool could not grow: fall thru and delete it
+                }
+            }
+            tally().freed++;
+        }
+
+        size_t size() const override { return free.size(); }
+
+        void trim(size_t limit) override {
+            if (free.size() > limit) {
+                free.resize(limit);
+            }
+        }
+
+        ~Pool() override {
+            gone = true;
+            for (Shelf **s = &shelves; *s; s = &(*s)->next) {
+                if (*s == this) {
+                    *s = next;
+                    break;
+                }
+            }
+        }
+
+    private:
+        vector<unique_ptr<C>> free;
+
+        Pool() {
+            next = shelves;
+            shelves = this;
+        }
+
+        // a container can be released after its thread's pool is gone (a thread_local or static Pooled destroyed at
+        // exit): it is deleted then. gone is trivially destructible so it is still readable
+        static inline thread_local bool gone = false;
+
+        static Pool *mine() {
+            if (gone) {
+                return nullptr;
+            }
+            thread_local Pool p;
+            return &p;
+        }
+    };
 };
 
 #endif //CPP_CONTAINER_FACTORY_H
@@ -0,0 +1,53 @@
+#ifndef CPP_CONTAINER_HANDLE_H
+#define CPP_CONTAINER_HANDLE_H
+
+#include <span>
+#include <utility>
+#include <variant>
+#include "Vector_Container.h"
+#include "Span_Container.h"
+
+// the closed-set alternative to unique_ptr<Container1>: when we know every container type up front they can go in a
+// variant. No heap allocation for the handle itself, and std::visit is a switch on the index that calls the final
+// (non-virtual) member of the type it holds - the compiler can inline it. Container1 stays for the open set (types
+// we don't know about when this is compiled).
+// For inner loops don't even visit per element: get values() once and loop over the span.
+class Container_Handle {
+public:
+    using Alternatives = variant<Vector_Container, Span_Container>;
+private:
+    Alternatives c;
+public:
+    template<typename C, typename... Args>
+    explicit Container_Handle(in_place_type_t<C> t, Args &&... args) : c(t, std::forward<Args>(args)...) {}
+
+    Container_Handle(Vector_Container &&v) : c(std::move(v)) {}
+
+    Container_Handle(Span_Container s) : c(s) {}
+
+    [[nodiscard]] int length() const {
+        return visit([](const auto &x) { return x.length(); }, c);
+    }
+
+    double &operator[](int i) {
+        return visit([i](auto &x) -> double & { return x[i]; }, c);
+    }
+
+    [[nodiscard]] double *data() noexcept {
+        return visit([](auto &x) { return x.data(); }, c);
+    }
+
+    [[nodiscard]] span<double> values() noexcept {
+        return visit([](auto &x) { return span<double>(x.values()); }, c);
+    }
+
+    double *begin() noexcept { return data(); }
+
+    double *end() noexcept { return data() + length(); }
+
+    // the underlying container, e.g. holds<Span_Container>() - for the odd case that needs to know which one it is
+    template<typename C>
+    [[nodiscard]] bool holds() const noexcept { return holds_alternative<C>(c); }
+};
+
+#endif //CPP_CONTAINER_HANDLE_H
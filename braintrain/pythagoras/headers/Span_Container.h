@@ -0,0 +1,27 @@
+#ifndef CPP_SPAN_CONTAINER_H
+#define CPP_SPAN_CONTAINER_H
+
+#include <span>
+#include "Container1.h"
+using namespace std;
+
+// a Container1 over memory it does not own (a c array, a std::vector, another container's data()). Copying it copies
+// the view not the doubles, and the memory must outlive it
+class Span_Container final : public Container1 {
+private:
+    span<double> items;
+public:
+    Span_Container(double *, int);
+
+    explicit Span_Container(span<double>);
+
+    int length() const override;
+
+    double &operator[](int i) override;
+
+    [[nodiscard]] double *data() const noexcept { return items.data(); }
+
+    [[nodiscard]] span<double> values() const noexcept { return items; }
+};
+
+#endif //CPP_SPAN_CONTAINER_H
@@ -1,19 +1,44 @@
 #ifndef CPP_VECTOR_CONTAINER_H
 #define CPP_VECTOR_CONTAINER_H
 
+#include <span>
 #include "Container1.h"
 using namespace std;
 
-class Vector_Container : public Container1 {
+// final: nothing derives from it, so a call thru a Vector_Container (not a Container1) can be devirtualized and inlined
+class Vector_Container final : public Container1 {
 private:
     N::Vector vec; // N is the name space defined in Vector.h
 public:
     Vector_Container(initializer_list<double>);
 
+    explicit Vector_Container(int); // n zeroes
+
+    // the user declared dtor below would otherwise suppress the implicit move (and a variant of them would copy)
+    Vector_Container(const Vector_Container &) = default;
+
+    Vector_Container(Vector_Container &&) noexcept = default;
+
+    Vector_Container &operator=(const Vector_Container &) = default;
+
+    Vector_Container &operator=(Vector_Container &&) noexcept = default;
+
+    // refill with new values: the buffer is reused when the length is the same (the pooled factory relies on it)
+    void assign(initializer_list<double>);
+
     int length() const override;
 
     double &operator[](int i) override;
 
+    // bulk access: no virtual call and no bounds check per element, so loops over it can be vectorized
+    [[nodiscard]] double *data() noexcept { return vec.data(); }
+
+    [[nodiscard]] const double *data() const noexcept { return vec.data(); }
+
+    [[nodiscard]] span<double> values() noexcept { return {vec.data(), static_cast<size_t>(vec.get_size())}; }
+
+    [[nodiscard]] span<const double> values() const noexcept { return {vec.data(), static_cast<size_t>(vec.get_size())}; }
+
     ~Vector_Container() override;
 };
 
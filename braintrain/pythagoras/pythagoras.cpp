@@ -1,7 +1,12 @@
+#include <chrono>
 #include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
 #include "headers/Complex3.h"
 #include "headers/Container1.h"
 #include "headers/Container_Factory.h"
+#include "headers/Container_Handle.h"
 
 using namespace std;
 
@@ -42,10 +47,149 @@ void class_inheritance() {
     polymorphic(vec_cont);
 }
 
+// same interface as the unique_ptr<Container1> version but the set of types is closed (a variant) so nothing is virtual
+void closed_set(Container_Handle &c) {
+    cout << c.length() << " - " << c[1] << endl;
+}
+
+void container_handles() {
+    cout << "container_handles" << endl;
+    Container_Handle owning {Vector_Container {1.2, 7.9, 1.1}};
+    closed_set(owning);
+
+    double raw[] {3.3, 4.4, 5.5, 6.6};
+    Container_Handle view {Span_Container {raw, 4}}; // no copy: writes go to raw
+    view[0] = 0.3;
+    closed_set(view);
+    cout << "raw[0] = " << raw[0] << " - holds a span: " << view.holds<Span_Container>() << endl;
+
+    // begin/end make it usable by range-for and the std algorithms
+    cout << "sum = " << accumulate(view.begin(), view.end(), 0.0) << endl;
+}
+
+// element access thru the virtual operator[] (one indirect call + bounds check per element), thru the variant handle
+// (a visit per element but the call can be inlined) and over the span (a plain loop the compiler vectorizes)
+void element_access_benchmark() {
+    cout << "element_access_benchmark" << endl;
+    using namespace chrono;
+    const int len = 4'000'000;
+    const int rounds = 20;
+
+    unique_ptr<Container1> virt = make_unique<Vector_Container>(len);
+    Container_Handle handle {in_place_type<Vector_Container>, len};
+    vector<double> backing(len);
+    Container_Handle view {Span_Container {backing.data(), len}};
+    for (int i = 0; i != len; i++) {
+        double x = (i % 100) * 0.5;
+        (*virt)[i] = x;
+        handle[i] = x;
+        backing[i] = x;
+    }
+
+    auto time_it = [&](const string &name, auto reduce) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            s += reduce();
+        }
+        auto t2 = high_resolution_clock::now();
+        double ns = duration<double, nano>(t2 - t1).count() / rounds / len;
+        cout << name << ": " << ns << " ns/element (checksum " << s / rounds << ")" << endl;
+    };
+
+    time_it("virtual-operator[]", [&] {
+        Container1 &c = *virt;
+        double s = 0;
+        for (int i = 0; i != c.length(); i++) {
+            s += c[i];
+        }
+        return s;
+    });
+    time_it("handle-operator[]", [&] {
+        double s = 0;
+        for (int i = 0; i != handle.length(); i++) {
+            s += handle[i];
+        }
+        return s;
+    });
+    time_it("handle-span", [&] {
+        double s = 0;
+        for (double x : handle.values()) {
+            s += x;
+        }
+        return s;
+    });
+    time_it("view-span", [&] {
+        double s = 0;
+        for (double x : view.values()) {
+            s += x;
+        }
+        return s;
+    });
+}
+
+void print_stats(const string &when) {
+    Container_Factory::Stats st = Container_Factory::stats();
+    cout << when << ": created " << st.created << ", reused " << st.reused << ", recycled " << st.recycled
+         << ", freed " << st.freed << ", pooled " << st.pooled << endl;
+}
+
+void pooled_containers() {
+    cout << "pooled_containers" << endl;
+    // the type is picked by name (or the enum) instead of a magic int
+    unique_ptr<Container1> fresh = Container_Factory::create("vector", {1.0, 2.0});
+    cout << fresh->length() << " - " << (*fresh)[1] << endl;
+    try {
+        Container_Factory::create("matrix", {1.0});
+    } catch (const invalid_argument &e) {
+        cout << "invalid_argument: " << e.what() << endl;
+    }
+    // a new type can be registered from anywhere; Vector_Container has assign() so it is pooled
+    Container_Factory::register_type<Vector_Container>("small-vector");
+
+    {
+        Container_Factory::Pooled c1 = Container_Factory::acquire(Container_Type::vector, {1.2, 7.9, 1.1});
+        Container_Factory::Pooled c2 = Container_Factory::acquire("small-vector", {3.3});
+        cout << c1->length() << " - " << (*c1)[1] << ", " << c2->length() << " - " << (*c2)[0] << endl;
+    } // both go back to their pool here (the Recycler deleter), nothing is freed
+    print_stats("after release");
+
+    Container_Factory::Pooled c3 = Container_Factory::acquire(Container_Type::vector, {4.4, 5.5, 6.6});
+    cout << "reused: " << c3->length() << " - " << (*c3)[1] << endl;
+    print_stats("after reuse");
+}
+
+// allocate/free a container per iteration (what createContainer did) vs recycling them thru the pool
+void container_churn_benchmark() {
+    cout << "container_churn_benchmark" << endl;
+    using namespace chrono;
+    const int rounds = 1'000'000;
+
+    auto time_it = [&](const string &name, auto make) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int r = 0; r != rounds; r++) {
+            auto c = make(r);
+            s += (*c)[2];
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, nano>(t2 - t1).count() / rounds << " ns/container (checksum " << s << ")" << endl;
+    };
+
+    time_it("new/delete", [](int r) { return Container_Factory::createContainer({1.0, 2.0, r * 1.0, 4.0}, 1); });
+    time_it("pooled", [](int r) { return Container_Factory::acquire(Container_Type::vector, {1.0, 2.0, r * 1.0, 4.0}); });
+    print_stats("after churn");
+    Container_Factory::drain();
+}
+
 int main() {
     const_call_rules();
     add_complex_nums();
     class_inheritance();
+    container_handles();
+    element_access_benchmark();
+    pooled_containers();
+    container_churn_benchmark();
 
     return 0;
 }
\ No newline at end of file
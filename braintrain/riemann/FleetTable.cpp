@@ -0,0 +1,265 @@
+#include <algorithm>
+#include "headers/FleetTable.h"
+
+#ifdef BRAINTRAIN_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    using Cmp = FleetTable::Cmp;
+    using Isa = FleetTable::Isa;
+
+    // a query runs block by block: the conditions narrow a mask of the block's rows (-1 passes, 0 does not) one column at
+    // a time, then the mask is tallied per kind. 2048 rows keep the mask (8 KB) and the columns being read in L1
+    constexpr int block = 2048;
+
+    template<Cmp C>
+    inline bool passes(int a, int v) {
+        if constexpr (C == Cmp::less) {
+            return a < v;
+        } else if constexpr (C == Cmp::less_equal) {
+            return a <= v;
+        } else if constexpr (C == Cmp::greater) {
+            return a > v;
+        } else if constexpr (C == Cmp::greater_equal) {
+            return a >= v;
+        } else if constexpr (C == Cmp::equal) {
+            return a == v;
+        } else {
+            return a != v;
+        }
+    }
+
+    // the kernels: filter narrows the mask by one condition, tally adds up the rows left in it per kind
+    struct Kernels {
+        void (*filter)(const int *, int, Cmp, int, int32_t *);
+        void (*tally)(const int32_t *, const VehicleKind *, const int *, int, long *, long *);
+    };
+
+    template<Cmp C>
+    void filter_scalar_as(const int *col, int n, int v, int32_t *mask) {
+        for (int i = 0; i != n; i++) {
+            mask[i] &= -static_cast<int32_t>(passes<C>(col[i], v));
+        }
+    }
+
+    // the switch is outside the loop: one instantiation of the loop per comparison
+    template<template<Cmp> typename Loop>
+    void by_cmp(const int *col, int n, Cmp c, int v, int32_t *mask) {
+        switch (c) {
+            case Cmp::less:
+                return Loop<Cmp::less>::run(col, n, v, mask);
+            case Cmp::less_equal:
+                return Loop<Cmp::less_equal>::run(col, n, v, mask);
+            case Cmp::greater:
+                return Loop<Cmp::greater>::run(col, n, v, mask);
+            case Cmp::greater_equal:
+                return Loop<Cmp::greater_equal>::run(col, n, v, mask);
+            case Cmp::equal:
+                return Loop<Cmp::equal>::run(col, n, v, mask);
+            case Cmp::not_equal:
+                return Loop<Cmp::not_equal>::run(col, n, v, mask);
+        }
+    }
+
+    template<Cmp C>
+    struct FilterScalar {
+        static void run(const int *col, int n, int v, int32_t *mask) { filter_scalar_as<C>(col, n, v, mask); }
+    };
+
+    void filter_scalar(const int *col, int n, Cmp c, int v, int32_t *mask) {
+        by_cmp<FilterScalar>(col, n, c, v, mask);
+    }
+
+    void tally_scalar(const int32_t *mask, const VehicleKind *kinds, const int *sum_of, int n, long *counts, long *sums) {
+        for (int i = 0; i != n; i++) {
+            if (mask[i]) {
+                int k = static_cast<int>(kinds[i]);
+                counts[k]++;
+                if (sum_of) {
+                    sums[k] += sum_of[i];
+                }
+            }
+        }
+    }
+
+#ifdef BRAINTRAIN_X86
+    // avx2 only has == and signed >: the other comparisons are built from them
+    template<Cmp C>
+    __attribute__((target("avx2")))
+    inline __m256i passes8(__m256i a, __m256i v) {
+        if constexpr (C == Cmp::less) {
+            return _mm256_cmpgt_epi32(v, a);
+        } else if constexpr (C == Cmp::less_equal) {
+            return _mm256_xor_si256(_mm256_cmpgt_epi32(a, v), _mm256_set1_epi32(-1));
+        } else if constexpr (C == Cmp::greater) {
+            return _mm256_cmpgt_epi32(a, v);
+        } else if constexpr (C == Cmp::greater_equal) {
+            return _mm256_xor_si256(_mm256_cmpgt_epi32(v, a), _mm256_set1_epi32(-1));
+        } else if constexpr (C == Cmp::equal) {
+            return _mm256_cmpeq_epi32(a, v);
+        } else {
+            return _mm256_xor_si256(_mm256_cmpeq_epi32(a, v), _mm256_set1_epi32(-1));
+        }
+    }
+
+    template<Cmp C>
+    struct FilterAvx2 {
+        __attribute__((target("avx2")))
+        static void run(const int *col, int n, int v, int32_t *mask) {
+            const __m256i value = _mm256_set1_epi32(v);
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(col + i));
+                __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(mask + i), _mm256_and_si256(m, passes8<C>(a, value)));
+            }
+            filter_scalar_as<C>(col + i, n - i, v, mask + i);
+        }
+    };
+
+    void filter_avx2(const int *col, int n, Cmp c, int v, int32_t *mask) {
+        by_cmp<FilterAvx2>(col, n, c, v, mask);
+    }
+
+    // per kind: the mask of the rows of that kind, subtracted from a counter per lane (a -1 adds one) and, for the sums,
+    // the values under it widened to 64 bits so a block of big values cannot overflow
+    __attribute__((target("avx2")))
+    void tally_avx2(const int32_t *mask, const VehicleKind *kinds, const int *sum_of, int n, long *counts, long *sums) {
+        int vectors = n / 8 * 8;
+        for (int k = 0; k != vehicle_kinds; k++) {
+            const __m256i kind = _mm256_set1_epi32(k);
+            __m256i counted = _mm256_setzero_si256();
+            __m256i summed = _mm256_setzero_si256();
+            for (int i = 0; i != vectors; i += 8) {
+                __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+                __m256i row_kinds = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(kinds + i)));
+                __m256i hit = _mm256_and_si256(m, _mm256_cmpeq_epi32(row_kinds, kind));
+                counted = _mm256_sub_epi32(counted, hit);
+                if (sum_of) {
+                    __m256i values = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(sum_of + i)), hit);
+                    summed = _mm256_add_epi64(summed, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+                    summed = _mm256_add_epi64(summed, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+                }
+            }
+            alignas(32) int32_t c[8];
+            alignas(32) int64_t s[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(c), counted);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(s), summed);
+            for (int32_t x : c) {
+                counts[k] += x;
+            }
+            for (int64_t x : s) {
+                sums[k] += x;
+            }
+        }
+        tally_scalar(mask + vectors, kinds + vectors, sum_of ? sum_of + vectors : nullptr, n - vectors, counts, sums);
+    }
+#endif
+
+    // picked on the first query (common/headers/Dispatch.h); an avx-512 cpu runs the avx2 kernels
+    cpu::Dispatch<Kernels> &dispatch() {
+        static cpu::Dispatch<Kernels> d {
+                {Isa::scalar, {filter_scalar, tally_scalar}},
+#ifdef BRAINTRAIN_X86
+                {Isa::avx2, {filter_avx2, tally_avx2}},
+#endif
+        };
+        return d;
+    }
+}
+
+const char *kind_name(VehicleKind k) {
+    switch (k) {
+        case VehicleKind::truck:
+            return "truck";
+        case VehicleKind::sedan:
+            return "sedan";
+    }
+    return "unknown";
+}
+
+void FleetTable::add(VehicleKind k, int top_speed, int capacity) {
+    speeds.push_back(top_speed);
+    seats.push_back(capacity);
+    kind_column.push_back(k);
+}
+
+void FleetTable::add(const Truck &t) {
+    add(VehicleKind::truck, t.top_speed(), t.capacity());
+}
+
+void FleetTable::add(const Sedan &s) {
+    add(VehicleKind::sedan, s.top_speed(), s.capacity());
+}
+
+void FleetTable::reserve(int n) {
+    speeds.reserve(n);
+    seats.reserve(n);
+    kind_column.reserve(n);
+}
+
+void FleetTable::aggregate(const vector<Condition> &where, const int *sum_of, PerKind &counts, PerKind &sums) const {
+    const Kernels &k = dispatch().kernels();
+    counts.fill(0);
+    sums.fill(0);
+    int32_t mask[block];
+    for (int first = 0; first < size(); first += block) {
+        int n = min(block, size() - first);
+        fill_n(mask, n, -1);
+        for (const Condition &c : where) {
+            k.filter(column(c.column) + first, n, c.cmp, c.value, mask);
+        }
+        k.tally(mask, kind_column.data() + first, sum_of ? sum_of + first : nullptr, n, counts.data(), sums.data());
+    }
+}
+
+long FleetTable::count(const vector<Condition> &where) const {
+    PerKind by_kind = count_by_kind(where);
+    long total = 0;
+    for (long c : by_kind) {
+        total += c;
+    }
+    return total;
+}
+
+FleetTable::PerKind FleetTable::count_by_kind(const vector<Condition> &where) const {
+    PerKind counts {}, sums {};
+    aggregate(where, nullptr, counts, sums);
+    return counts;
+}
+
+FleetTable::PerKind FleetTable::sum_by_kind(Column c, const vector<Condition> &where) const {
+    PerKind counts {}, sums {};
+    aggregate(where, column(c), counts, sums);
+    return sums;
+}
+
+vector<int> FleetTable::select(const vector<Condition> &where) const {
+    const Kernels &k = dispatch().kernels();
+    vector<int> rows;
+    int32_t mask[block];
+    for (int first = 0; first < size(); first += block) {
+        int n = min(block, size() - first);
+        fill_n(mask, n, -1);
+        for (const Condition &c : where) {
+            k.filter(column(c.column) + first, n, c.cmp, c.value, mask);
+        }
+        for (int i = 0; i != n; i++) {
+            if (mask[i]) {
+                rows.push_back(first + i);
+            }
+        }
+    }
+    return rows;
+}
+
+FleetTable::Isa FleetTable::active_isa() noexcept {
+    return dispatch().active();
+}
+
+FleetTable::Isa FleetTable::use_isa(Isa isa) noexcept {
+    return dispatch().use(isa);
+}
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "headers/Predicates.h"
+
+// pred::count_if/find_if against a plain loop that compares by value (integers with cmp_*, anything else in long double,
+// which holds every value of the types below exactly), for element and bound types that c++ would convert badly
+namespace {
+    template<typename X, typename V>
+    partial_ordering by_value(X x, V v) {
+        if constexpr (is_integral_v<X> && is_integral_v<V>) {
+            return cmp_less(x, v) ? partial_ordering::less : cmp_equal(x, v) ? partial_ordering::equivalent
+                                                                             : partial_ordering::greater;
+        } else {
+            return static_cast<long double>(x) <=> static_cast<long double>(v);
+        }
+    }
+
+    // the values repeated and shuffled a bit, long enough for the 16 and 32-byte loops and a scalar tail
+    template<typename T>
+    vector<T> sample(const vector<T> &values) {
+        vector<T> out;
+        for (int i = 0; i != 301; i++) {
+            out.push_back(values[(i * 7) % values.size()]);
+        }
+        return out;
+    }
+
+    template<typename P, typename T, typename Ref>
+    void expect_same(const vector<T> &data, const P &p, Ref ref, const string &what) {
+        long count = 0, first = static_cast<long>(data.size());
+        for (long i = 0; i != static_cast<long>(data.size()); i++) {
+            if (ref(data[i])) {
+                count++;
+                first = min(first, i);
+            }
+        }
+        EXPECT_EQ(pred::count_if(data, p), count) << what;
+        EXPECT_EQ(pred::find_if(data, p), first) << what;
+        list<T> as_list(data.begin(), data.end()); // not contiguous: the scalar loop
+        EXPECT_EQ(pred::count_if(as_list, p), count) << what << " (list)";
+    }
+
+    template<typename T, typename V>
+    void check_bound(const vector<T> &data, V v) {
+        string what = string(typeid(T).name()) + " vs " + to_string(static_cast<long double>(v));
+        expect_same(data, pred::gt(v), [&](T x) { return by_value(x, v) > 0; }, what + " gt");
+        expect_same(data, pred::ge(v), [&](T x) { return by_value(x, v) >= 0; }, what + " ge");
+        expect_same(data, pred::lt(v), [&](T x) { return by_value(x, v) < 0; }, what + " lt");
+        expect_same(data, pred::le(v), [&](T x) { return by_value(x, v) <= 0; }, what + " le");
+        expect_same(data, pred::eq(v), [&](T x) { return by_value(x, v) == 0; }, what + " eq");
+        expect_same(data, pred::ne(v), [&](T x) { return by_value(x, v) != 0; }, what + " ne");
+        expect_same(data, !pred::gt(v) || pred::eq(v), [&](T x) { return !(by_value(x, v) > 0) || by_value(x, v) == 0; },
+                    what + " not gt or eq");
+    }
+
+    template<typename T>
+    void check_all_bounds(const vector<T> &values) {
+        vector<T> data = sample(values);
+        cpu::Isa was = pred::active_isa();
+        for (cpu::Isa isa : {cpu::Isa::sse2, cpu::Isa::avx2}) {
+            pred::use_isa(isa);
+            for (int v : {0, 2, -1, -2, 7, 127, 128, -128, -129, 255, 256, 300, -300, 16777217}) {
+                check_bound(data, v);
+            }
+            for (double v : {2.5, -2.5, 0.1, -0.5, 1e19, -1e19, 1e300, -1e300, 3.4028235e38, numeric_limits<double>::infinity(),
+                             -numeric_limits<double>::infinity(), numeric_limits<double>::quiet_NaN()}) {
+                check_bound(data, v);
+            }
+            check_bound(data, numeric_limits<uint64_t>::max());
+            check_bound(data, numeric_limits<int64_t>::min());
+            check_bound(data, 0.1f);
+            check_bound(data, 4'000'000'000u);
+        }
+        pred::use_isa(was);
+    }
+}
+
+TEST(Predicates, IntsAgainstFractionalBounds) {
+    vector<int> ints;
+    for (int i = -20; i != 20; i++) {
+        ints.push_back(i);
+    }
+    vector<int> data = sample(ints);
+    EXPECT_EQ(pred::count_if(vector<int> {0, 1, 2, 3, 4}, pred::eq(2.5)), 0);
+    EXPECT_EQ(pred::count_if(vector<int> {0, 1, 2, 3, 4}, pred::lt(2.5)), 3);
+    EXPECT_EQ(pred::count_if(vector<int> {0, 1, 2, 3, 4}, pred::between(0.5, 3.5)), 3);
+    check_all_bounds(ints);
+}
+
+TEST(Predicates, NarrowIntsAgainstWideBounds) {
+    EXPECT_EQ(pred::count_if(vector<int8_t>(40, 100), pred::gt(300)), 0);
+    EXPECT_EQ(pred::count_if(vector<int8_t>(40, 100), pred::lt(300)), 40);
+    vector<int8_t> i8;
+    for (int i = -128; i < 128; i += 3) {
+        i8.push_back(static_cast<int8_t>(i));
+    }
+    check_all_bounds(i8);
+    check_all_bounds(vector<int16_t> {-32768, -129, -1, 0, 2, 255, 300, 32767});
+}
+
+TEST(Predicates, UnsignedAgainstNegativeBounds) {
+    EXPECT_EQ(pred::count_if(vector<unsigned> {0, 1, 2}, pred::gt(-1)), 3);
+    EXPECT_EQ(pred::count_if(vector<unsigned> {0, 1, 2}, pred::ne(-1)), 3);
+    check_all_bounds(vector<uint8_t> {0, 1, 2, 127, 128, 254, 255});
+    check_all_bounds(vector<uint32_t> {0, 1, 2, 300, 16777217, 4'000'000'000u, numeric_limits<uint32_t>::max()});
+    check_all_bounds(vector<uint64_t> {0, 1, 2, 1ull << 63, numeric_limits<uint64_t>::max()});
+}
+
+TEST(Predicates, WideInts) {
+    check_all_bounds(vector<int64_t> {numeric_limits<int64_t>::min(), -300, -2, 0, 2, 300, numeric_limits<int64_t>::max()});
+}
+
+TEST(Predicates, FloatingPoint) {
+    const float inf = numeric_limits<float>::infinity(), nan = numeric_limits<float>::quiet_NaN();
+    check_all_bounds(vector<float> {-inf, -1e30f, -2.5f, -0.5f, 0.0f, 0.1f, 0.100000001f, 2.5f, 16777216.0f, 3e38f, inf, nan});
+    check_all_bounds(vector<double> {-numeric_limits<double>::infinity(), -2.5, 0.0, 0.1, 2.0, 1e19, 1e300,
+                                     numeric_limits<double>::quiet_NaN()});
+}
+
+TEST(Predicates, UseIsaCanBeUndone) {
+    cpu::Isa was = pred::active_isa();
+    EXPECT_EQ(pred::use_isa(cpu::Isa::sse2), cpu::Isa::sse2);
+    EXPECT_EQ(pred::active_isa(), cpu::Isa::sse2);
+    EXPECT_EQ(pred::use_isa(was), was);
+    EXPECT_EQ(pred::active_isa(), was);
+}
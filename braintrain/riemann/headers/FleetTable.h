@@ -0,0 +1,96 @@
+#ifndef BRAINTRAIN_FLEETTABLE_H
+#define BRAINTRAIN_FLEETTABLE_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Vehicle.h"
+#include "Truck.h"
+#include "Sedan.h"
+#include "PolyCollection.h"
+#include "../../common/headers/Dispatch.h"
+using namespace std;
+
+enum class VehicleKind : uint8_t {
+    truck, sedan
+};
+
+inline constexpr int vehicle_kinds = 2;
+
+const char *kind_name(VehicleKind);
+
+// the attributes of a fleet as columns (one int array per attribute and a byte array for the kind) rather than as objects.
+// A query reads the columns it filters and sums on and nothing else, 8 rows at a time with avx2 (picked by cpuid, scalar
+// otherwise like the einstein reductions), and never makes a Truck or a Sedan. "How many vehicles with capacity > 4, by
+// kind" over a million rows reads 5 MB of capacities and kinds instead of chasing a million pointers
+class FleetTable {
+public:
+    enum class Column {
+        top_speed, capacity
+    };
+
+    enum class Cmp {
+        less, less_equal, greater, greater_equal, equal, not_equal
+    };
+
+    // column cmp value: {Column::capacity, Cmp::greater, 4}
+    struct Condition {
+        Column column;
+        Cmp cmp;
+        int value;
+    };
+
+    using PerKind = array<long, vehicle_kinds>; // indexed by VehicleKind
+
+    using Isa = cpu::Isa;
+private:
+    vector<int> speeds;
+    vector<int> seats;
+    vector<VehicleKind> kind_column;
+
+    [[nodiscard]] const int *column(Column c) const { return c == Column::top_speed ? speeds.data() : seats.data(); }
+
+    // the rows that pass every condition, counted (and sum_of summed when it is given) per kind
+    void aggregate(const vector<Condition> &, const int *sum_of, PerKind &counts, PerKind &sums) const;
+public:
+    void add(VehicleKind, int top_speed, int capacity);
+
+    void add(const Truck &);
+
+    void add(const Sedan &);
+
+    // copies the attributes out of a PolyCollection fleet
+    template<typename... Ts>
+    void add_all(const PolyCollection<Vehicle, Ts...> &fleet) {
+        reserve(size() + fleet.size());
+        fleet.for_each([&](const auto &v) { add(v); });
+    }
+
+    void reserve(int);
+
+    [[nodiscard]] int size() const { return static_cast<int>(kind_column.size()); }
+
+    [[nodiscard]] span<const int> top_speeds() const { return speeds; }
+
+    [[nodiscard]] span<const int> capacities() const { return seats; }
+
+    [[nodiscard]] span<const VehicleKind> kinds() const { return kind_column; }
+
+    // the rows that pass all the conditions (none: every row)
+    [[nodiscard]] long count(const vector<Condition> & = {}) const;
+
+    [[nodiscard]] PerKind count_by_kind(const vector<Condition> & = {}) const;
+
+    [[nodiscard]] PerKind sum_by_kind(Column, const vector<Condition> & = {}) const;
+
+    [[nodiscard]] vector<int> select(const vector<Condition> &) const; // their row numbers
+
+    // the instruction set the queries run with; use_isa forces scalar for benchmarking (clamped to what the cpu supports).
+    // Safe while other threads are querying
+    static Isa active_isa() noexcept;
+
+    static Isa use_isa(Isa) noexcept;
+};
+
+#endif //BRAINTRAIN_FLEETTABLE_H
@@ -0,0 +1,230 @@
+#ifndef BRAINTRAIN_MAPPEDVECTOR_H
+#define BRAINTRAIN_MAPPEDVECTOR_H
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../common/headers/Lifecycle.h"
+using namespace std;
+
+// how the elements are about to be read: the kernel sizes its read-ahead by it (madvise)
+enum class Access {
+    normal, // the default read-ahead
+    sequential, // aggressive read-ahead, and pages behind the reader can be dropped early
+    random, // no read-ahead: every fault reads just the page it needs
+    will_need, // start reading the range in now
+    dont_need // the range can be dropped from the page cache (written pages are not lost: they stay in the file)
+};
+
+// a vector whose elements live in a file mapped into memory (mmap) instead of on the heap. Nothing is read up front: a page
+// (4 KB) is read the first time it is touched and the kernel drops clean pages when it runs short of memory, so the file
+// can be much bigger than RAM. Writes go to the page cache and reach the disk when the kernel gets to it, or at sync().
+// T has to be trivially copyable: the file holds the raw bytes of the elements (so it is only readable on machines with the
+// same endianness and sizeof(T)). The length is a long: a few GB of doubles is already past the reach of an int.
+// Same interface as TVector (operator[], get_size, begin/end) so the algorithms that take a TVector take this too
+template<typename T>
+class MappedVector {
+    static_assert(is_trivially_copyable_v<T>, "a mapped vector stores the raw bytes of its elements");
+public:
+    enum class Mode {
+        read_only, read_write
+    };
+private:
+    long length;
+    T *items; // nullptr for an empty file (there is no such thing as an empty mapping)
+    bool writable;
+
+    MappedVector(const string &, int flags, Mode, long); // len < 0: take the length from the file
+
+    void unmap() noexcept;
+
+    [[noreturn]] static void fail(const string &what, const string &path) {
+        throw system_error(errno, generic_category(), what + " " + path);
+    }
+public:
+    // creates the file (or truncates an existing one) and sizes it for n elements, all zero bytes. The file is sparse: the
+    // disk blocks are only taken as the pages are written
+    static MappedVector create(const string &, long);
+
+    // maps an existing file; its size must be a whole number of elements
+    static MappedVector open(const string &, Mode = Mode::read_write);
+
+    MappedVector(const MappedVector &) = delete; // two mappings of one file would both be unmapped: move it instead
+
+    MappedVector &operator=(const MappedVector &) = delete;
+
+    MappedVector(MappedVector &&) noexcept;
+
+    MappedVector &operator=(MappedVector &&) noexcept;
+
+    ~MappedVector(); // unmaps: the written pages still reach the file, but without waiting for the disk
+
+    [[nodiscard]] long get_size() const { return length; }
+
+    [[nodiscard]] bool is_writable() const { return writable; }
+
+    // writing thru a read_only mapping is a segfault (the pages are mapped without write permission)
+    T *begin() const { return items; }
+
+    T *end() const { return items + length; }
+
+    T *data() const { return items; }
+
+    T &operator[](long i) { return items[i]; } // unchecked like TVector: a bad index is a segfault or garbage
+
+    const T &operator[](long i) const { return items[i]; }
+
+    // the whole vector, or count elements from first (the range is widened to whole pages)
+    void advise(Access) const;
+
+    void advise(Access, long first, long count) const;
+
+    // writes the dirty pages to the file: wait = true blocks until they are on the disk, false only schedules them
+    void sync(bool wait = true) const;
+};
+
+template<typename T>
+MappedVector<T>::MappedVector(const string &path, int flags, Mode mode, long len): length {0}, items {nullptr},
+                                                                                    writable {mode == Mode::read_write} {
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        fail("cannot open", path);
+    }
+    // the mapping keeps the file open by itself so the descriptor is closed whatever happens
+    struct Closer {
+        int fd;
+
+        ~Closer() { ::close(fd); }
+    } closer {fd};
+    if (len >= 0) {
+        if (::ftruncate(fd, static_cast<off_t>(len * sizeof(T))) != 0) {
+            fail("cannot size", path);
+        }
+    } else {
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            fail("cannot stat", path);
+        }
+        if (st.st_size % sizeof(T) != 0) {
+            throw length_error(path + " is " + to_string(st.st_size) + " bytes: not a whole number of " +
+                               to_string(sizeof(T)) + "-byte elements");
+        }
+        len = static_cast<long>(st.st_size / sizeof(T));
+    }
+    if (len > 0) {
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *p = ::mmap(nullptr, len * sizeof(T), prot, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            fail("cannot map", path);
+        }
+        items = static_cast<T *>(p);
+    }
+    length = len;
+    lifecycle::constructed<MappedVector>();
+}
+
+template<typename T>
+MappedVector<T> MappedVector<T>::create(const string &path, long len) {
+    if (len < 0) {
+        throw length_error("negative vector length: " + to_string(len));
+    }
+    return MappedVector(path, O_RDWR | O_CREAT | O_TRUNC, Mode::read_write, len);
+}
+
+template<typename T>
+MappedVector<T> MappedVector<T>::open(const string &path, Mode mode) {
+    return MappedVector(path, mode == Mode::read_write ? O_RDWR : O_RDONLY, mode, -1);
+}
+
+template<typename T>
+MappedVector<T>::MappedVector(MappedVector<T> &&v) noexcept: length {v.length}, items {v.items}, writable {v.writable} {
+    lifecycle::moved<MappedVector>();
+    v.length = 0;
+    v.items = nullptr;
+}
+
+template<typename T>
+MappedVector<T> &MappedVector<T>::operator=(MappedVector<T> &&v) noexcept {
+    if (&v == this) {
+        return *this;
+    }
+    lifecycle::move_assigned<MappedVector>();
+    unmap();
+    length = v.length;
+    items = v.items;
+    writable = v.writable;
+    v.length = 0;
+    v.items = nullptr;
+    return *this;
+}
+
+template<typename T>
+MappedVector<T>::~MappedVector() {
+    lifecycle::destroyed<MappedVector>();
+    unmap();
+}
+
+template<typename T>
+void MappedVector<T>::unmap() noexcept {
+    if (items) {
+        ::munmap(items, length * sizeof(T));
+        items = nullptr;
+    }
+}
+
+template<typename T>
+void MappedVector<T>::advise(Access a) const {
+    advise(a, 0, length);
+}
+
+template<typename T>
+void MappedVector<T>::advise(Access a, long first, long count) const {
+    if (first < 0 || count < 0 || first + count > length) {
+        throw out_of_range("advise range [" + to_string(first) + ", " + to_string(first + count) + ") outside a vector of " +
+                           to_string(length));
+    }
+    if (count == 0) {
+        return;
+    }
+    int advice = MADV_NORMAL;
+    switch (a) {
+        case Access::normal:
+            advice = MADV_NORMAL;
+            break;
+        case Access::sequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case Access::random:
+            advice = MADV_RANDOM;
+            break;
+        case Access::will_need:
+            advice = MADV_WILLNEED;
+            break;
+        case Access::dont_need:
+            advice = MADV_DONTNEED;
+            break;
+    }
+    // madvise wants a page aligned start: round down (the mapping itself starts on a page)
+    static const long page = ::sysconf(_SC_PAGESIZE);
+    auto start = reinterpret_cast<uintptr_t>(items + first);
+    uintptr_t aligned = start & ~static_cast<uintptr_t>(page - 1);
+    if (::madvise(reinterpret_cast<void *>(aligned), start - aligned + count * sizeof(T), advice) != 0) {
+        throw system_error(errno, generic_category(), "madvise");
+    }
+}
+
+template<typename T>
+void MappedVector<T>::sync(bool wait) const {
+    if (items && writable && ::msync(items, length * sizeof(T), wait ? MS_SYNC : MS_ASYNC) != 0) {
+        throw system_error(errno, generic_category(), "msync");
+    }
+}
+
+#endif //BRAINTRAIN_MAPPEDVECTOR_H
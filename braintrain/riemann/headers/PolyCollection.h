@@ -0,0 +1,97 @@
+#ifndef BRAINTRAIN_POLYCOLLECTION_H
+#define BRAINTRAIN_POLYCOLLECTION_H
+
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// a polymorphic collection without a pointer per object: every concrete type gets its own vector (a segment) and the
+// objects are stored in it by value, one after the other. vector<shared_ptr<Vehicle>> is a heap node and a control block
+// per object, wherever the allocator put them, and a virtual call per element; here a scan walks Ts... contiguous arrays
+// and for_each hands the lambda each object as its concrete type, so the dispatch is resolved once per segment (the
+// compiler knows the type: the call is direct, or inlined when the function is visible).
+// The set of types is fixed at compile time: PolyCollection<Vehicle, Truck, Sedan>. The order of the objects across
+// types is not kept (all the Trucks come before all the Sedans), within a type it is the insertion order.
+// Like any vector, adding an object can move the others: do not keep references across an insert
+template<typename Base, typename... Ts>
+class PolyCollection {
+    static_assert((is_base_of_v<Base, Ts> && ...), "every segment type must derive from the base");
+private:
+    tuple<vector<Ts>...> segments;
+public:
+    template<typename T, typename... Args>
+    T &emplace(Args &&... args) {
+        return get<vector<T>>(segments).emplace_back(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void insert(T &&object) {
+        get<vector<remove_cvref_t<T>>>(segments).push_back(std::forward<T>(object));
+    }
+
+    template<typename T>
+    void reserve(int n) {
+        get<vector<T>>(segments).reserve(n);
+    }
+
+    // the objects of one type, contiguous
+    template<typename T>
+    span<T> segment() {
+        return get<vector<T>>(segments);
+    }
+
+    template<typename T>
+    span<const T> segment() const {
+        return get<vector<T>>(segments);
+    }
+
+    [[nodiscard]] int size() const {
+        return static_cast<int>((get<vector<Ts>>(segments).size() + ... + 0));
+    }
+
+    template<typename T>
+    [[nodiscard]] int size() const {
+        return static_cast<int>(get<vector<T>>(segments).size());
+    }
+
+    void clear() {
+        (get<vector<Ts>>(segments).clear(), ...);
+    }
+
+    // f is called with every object as its concrete type (a generic lambda: [](const auto &v) {...}), segment by segment
+    template<typename F>
+    void for_each(F &&f) {
+        (for_each_in<Ts>(f), ...);
+    }
+
+    template<typename F>
+    void for_each(F &&f) const {
+        (for_each_in<Ts>(f), ...);
+    }
+
+    // f gets a span of each segment: for the loops that want the whole array (a reduction, a simd kernel...)
+    template<typename F>
+    void for_each_segment(F &&f) const {
+        (f(segment<Ts>()), ...);
+    }
+
+private:
+    template<typename T, typename F>
+    void for_each_in(F &f) {
+        for (T &object : get<vector<T>>(segments)) {
+            f(object);
+        }
+    }
+
+    template<typename T, typename F>
+    void for_each_in(F &f) const {
+        for (const T &object : get<vector<T>>(segments)) {
+            f(object);
+        }
+    }
+};
+
+#endif //BRAINTRAIN_POLYCOLLECTION_H
@@ -0,0 +1,570 @@
+#ifndef BRAINTRAIN_PREDICATES_H
+#define BRAINTRAIN_PREDICATES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <type_traits>
+#include "../../common/headers/Dispatch.h"
+using namespace std;
+
+// predicates that count_if/find_if can run 16 or 32 bytes at a time: gt(500), between(100, 200) || lt(0), !eq(7)...
+// Each one is a small object that tests one value (operator(), like function_object_gt) AND, once bound to the element
+// type (bind<T>), a whole vector of values at once (mask: a lane of all ones where the test passes). Over a contiguous
+// array of an arithmetic type the engine binds the expression, loads a vector, computes the mask of the whole expression
+// with compares and and/or/not, and counts it by subtracting it from a per-lane counter: no branch per element, so
+// nothing for the branch predictor to get wrong on a 50/50 filter.
+// The vector code is written with the gcc/clang vector extensions (T __attribute__((vector_size(N)))) rather than with
+// intrinsics: one body works for every element type from int8 to double, and it is compiled twice, for avx2 (32 bytes) and
+// for the sse2 baseline (16 bytes), with the avx2 copy used when the cpu has it (common/headers/Dispatch.h).
+// Anything else (a generic lambda, a list, a strided view) goes thru the scalar loop, which is still branchless.
+// The vector helpers fill a reference instead of returning a vector: gcc warns about (and would change the ABI of) any
+// function taking or returning a 32-byte vector by value in a TU not built with -mavx, always inlined or not
+namespace pred {
+    // (a typedef in a struct: gcc drops the attribute from an alias template of a dependent type)
+    template<typename T, int Bytes>
+    struct vector_of {
+        typedef T type __attribute__((vector_size(Bytes)));
+    };
+
+    template<typename T, int Bytes>
+    using vec = typename vector_of<T, Bytes>::type;
+
+    // the integer type of a compare's result lanes (the same width as the element)
+    template<typename T>
+    using lane_int = conditional_t<sizeof(T) == 1, int8_t, conditional_t<sizeof(T) == 2, int16_t,
+            conditional_t<sizeof(T) == 4, int32_t, int64_t>>>;
+
+    // the marker the engine looks for: a predicate-algebra node
+    template<typename P>
+    concept Predicate = remove_cvref_t<P>::is_predicate;
+
+    namespace detail {
+        // a < b by value, whatever the signedness of the two integer types (what std::cmp_less does, which does not take
+        // char)
+        template<typename A, typename B>
+        constexpr bool less(A a, B b) {
+            if constexpr (is_signed_v<A> == is_signed_v<B>) {
+                return a < b;
+            } else if constexpr (is_signed_v<A>) {
+                return a < 0 || static_cast<make_unsigned_t<A>>(a) < b;
+            } else {
+                return b >= 0 && a < static_cast<make_unsigned_t<B>>(b);
+            }
+        }
+
+        // where a bound sits among the values of the element type T: lo is the largest T <= the bound and hi the smallest
+        // T >= it, when there is one. They are the same T when the bound converts exactly
+        template<typename T>
+        struct Bracket {
+            T lo {};
+            T hi {};
+            bool has_lo = false;
+            bool has_hi = false;
+            bool nan = false; // a NaN bound: nothing compares to it
+
+            [[nodiscard]] bool exact() const { return has_lo && has_hi && lo == hi; }
+        };
+
+        // long double holds every int64/uint64 and every double exactly (x86: a 64-bit mantissa), so the range checks
+        // and the rounding test below compare the true values
+        template<typename T, typename V>
+        Bracket<T> bracket(V v) {
+            Bracket<T> b;
+            if constexpr (is_floating_point_v<V>) {
+                if (isnan(v)) {
+                    b.nan = true;
+                    return b;
+                }
+            }
+            if constexpr (is_integral_v<T> && is_integral_v<V>) {
+                if (less(v, numeric_limits<T>::min())) {
+                    b.hi = numeric_limits<T>::min(), b.has_hi = true;
+                } else if (less(numeric_limits<T>::max(), v)) {
+                    b.lo = numeric_limits<T>::max(), b.has_lo = true;
+                } else {
+                    b.lo = b.hi = static_cast<T>(v), b.has_lo = b.has_hi = true;
+                }
+            } else if constexpr (is_integral_v<T>) { // a fractional bound over integers: round it both ways
+                auto w = static_cast<long double>(v);
+                if (w < static_cast<long double>(numeric_limits<T>::min())) {
+                    b.hi = numeric_limits<T>::min(), b.has_hi = true;
+                } else if (w > static_cast<long double>(numeric_limits<T>::max())) {
+                    b.lo = numeric_limits<T>::max(), b.has_lo = true;
+                } else {
+                    b.lo = static_cast<T>(floorl(w)), b.hi = static_cast<T>(ceill(w)), b.has_lo = b.has_hi = true;
+                }
+            } else { // floating elements have the infinities, so lo and hi always exist
+                auto w = static_cast<long double>(v);
+                constexpr T inf = numeric_limits<T>::infinity();
+                b.has_lo = b.has_hi = true;
+                if (!isinf(w) && w > static_cast<long double>(numeric_limits<T>::max())) {
+                    b.lo = numeric_limits<T>::max(), b.hi = inf;
+                } else if (!isinf(w) && w < static_cast<long double>(numeric_limits<T>::lowest())) {
+                    b.lo = -inf, b.hi = numeric_limits<T>::lowest();
+                } else {
+                    auto t = static_cast<T>(w);
+                    if (static_cast<long double>(t) == w) {
+                        b.lo = b.hi = t;
+                    } else if (static_cast<long double>(t) < w) {
+                        b.lo = t, b.hi = nextafter(t, inf);
+                    } else {
+                        b.lo = nextafter(t, -inf), b.hi = t;
+                    }
+                }
+            }
+            return b;
+        }
+
+        // what a compare bound to an element type does: compare with a T, or pass everything, or nothing
+        enum class Outcome {
+            compare, all, none
+        };
+    }
+
+    // each op knows which side of the bracket to compare with: x > 2.5 over ints is x > 2, x >= 2.5 is x >= 3, and x > 300
+    // over int8 passes nothing
+    struct Greater {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a > b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.lo;
+            return b.nan ? detail::Outcome::none : b.has_lo ? detail::Outcome::compare : detail::Outcome::all;
+        }
+    };
+
+    struct GreaterEqual {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a >= b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.hi;
+            return b.nan ? detail::Outcome::none : b.has_hi ? detail::Outcome::compare : detail::Outcome::none;
+        }
+    };
+
+    struct Less {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a < b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.hi;
+            return b.nan ? detail::Outcome::none : b.has_hi ? detail::Outcome::compare : detail::Outcome::all;
+        }
+    };
+
+    struct LessEqual {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a <= b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.lo;
+            return b.nan ? detail::Outcome::none : b.has_lo ? detail::Outcome::compare : detail::Outcome::none;
+        }
+    };
+
+    struct Equal {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a == b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.lo;
+            return b.exact() ? detail::Outcome::compare : detail::Outcome::none;
+        }
+    };
+
+    struct NotEqual {
+        template<typename A, typename B, typename R>
+        [[gnu::always_inline]] static void apply(const A &a, const B &b, R &result) { result = a != b; }
+
+        template<typename T>
+        static detail::Outcome bind(const detail::Bracket<T> &b, T &with) {
+            with = b.lo;
+            return b.exact() ? detail::Outcome::compare : detail::Outcome::all; // a NaN bound too: x != NaN always holds
+        }
+    };
+
+    // a Compare bound to the element type T of the sequence being tested: the value is already a T, or the outcome is a
+    // constant when no T compares the same way as the bound
+    template<typename T, typename Op>
+    struct Test {
+        static constexpr bool is_predicate = true;
+        T value;
+        detail::Outcome outcome;
+
+        template<typename U>
+        const Test &bind() const {
+            static_assert(is_same_v<U, T>, "bound to another element type");
+            return *this;
+        }
+
+        // every leaf compares: the vector loops can run it. A constant leaf (a bound out of range, a NaN) only shows up
+        // in odd queries, and those take the scalar loop rather than costing every other query a mask per leaf
+        [[nodiscard]] bool plain() const { return outcome == detail::Outcome::compare; }
+
+        bool operator()(T x) const {
+            bool pass;
+            Op::apply(x, value, pass);
+            return outcome == detail::Outcome::compare ? pass : outcome == detail::Outcome::all;
+        }
+
+        template<typename U, int Bytes>
+        [[gnu::always_inline]] void mask(const vec<T, Bytes> &x, vec<lane_int<T>, Bytes> &m) const {
+            Op::apply(x, value, m); // vector op scalar: the scalar is broadcast to every lane
+        }
+    };
+
+    // element op value, compared by value like the math says and not like c++ converts: over ints eq(2.5) passes
+    // nothing and lt(2.5) passes 2, over unsigned gt(-1) passes everything, over int8 gt(300) passes nothing. The engine
+    // binds it to the element type once per call (bind<T>), which maps the value onto a T or a constant (see bracket)
+    template<typename V, typename Op>
+    struct Compare {
+        static constexpr bool is_predicate = true;
+        V value;
+
+        template<typename T>
+        Test<T, Op> bind() const {
+            T with {};
+            detail::Outcome o = Op::bind(detail::bracket<T>(value), with);
+            return {with, o};
+        }
+
+        // one element: binds on every call, the count_if/find_if loops bind once instead
+        template<typename T>
+        bool operator()(T x) const {
+            if constexpr (is_arithmetic_v<T> && !is_same_v<T, bool>) {
+                return bind<T>()(x);
+            } else {
+                bool pass;
+                Op::apply(x, value, pass);
+                return pass;
+            }
+        }
+    };
+
+    // lo <= element <= hi
+    template<typename V>
+    struct Between {
+        static constexpr bool is_predicate = true;
+        V lo;
+        V hi;
+
+        template<typename T>
+        auto bind() const { return Compare<V, GreaterEqual> {lo}.template bind<T>() && Compare<V, LessEqual> {hi}.template bind<T>(); }
+
+        template<typename T>
+        bool operator()(T x) const { return Compare<V, GreaterEqual> {lo}(x) & Compare<V, LessEqual> {hi}(x); }
+    };
+
+    // & and | rather than && and ||: both sides are always evaluated, which is what avoids the branch
+    template<typename L, typename R>
+    struct And {
+        static constexpr bool is_predicate = true;
+        L left;
+        R right;
+
+        template<typename T>
+        auto bind() const {
+            auto l = left.template bind<T>();
+            auto r = right.template bind<T>();
+            return And<decltype(l), decltype(r)> {l, r};
+        }
+
+        [[nodiscard]] bool plain() const { return left.plain() && right.plain(); }
+
+        template<typename T>
+        bool operator()(T x) const { return left(x) & right(x); }
+
+        template<typename T, int Bytes>
+        [[gnu::always_inline]] void mask(const vec<T, Bytes> &x, vec<lane_int<T>, Bytes> &m) const {
+            vec<lane_int<T>, Bytes> r;
+            left.template mask<T, Bytes>(x, m);
+            right.template mask<T, Bytes>(x, r);
+            m &= r;
+        }
+    };
+
+    template<typename L, typename R>
+    struct Or {
+        static constexpr bool is_predicate = true;
+        L left;
+        R right;
+
+        template<typename T>
+        auto bind() const {
+            auto l = left.template bind<T>();
+            auto r = right.template bind<T>();
+            return Or<decltype(l), decltype(r)> {l, r};
+        }
+
+        [[nodiscard]] bool plain() const { return left.plain() && right.plain(); }
+
+        template<typename T>
+        bool operator()(T x) const { return left(x) | right(x); }
+
+        template<typename T, int Bytes>
+        [[gnu::always_inline]] void mask(const vec<T, Bytes> &x, vec<lane_int<T>, Bytes> &m) const {
+            vec<lane_int<T>, Bytes> r;
+            left.template mask<T, Bytes>(x, m);
+            right.template mask<T, Bytes>(x, r);
+            m |= r;
+        }
+    };
+
+    template<typename P>
+    struct Not {
+        static constexpr bool is_predicate = true;
+        P inner;
+
+        template<typename T>
+        auto bind() const {
+            auto i = inner.template bind<T>();
+            return Not<decltype(i)> {i};
+        }
+
+        [[nodiscard]] bool plain() const { return inner.plain(); }
+
+        template<typename T>
+        bool operator()(T x) const { return !inner(x); }
+
+        template<typename T, int Bytes>
+        [[gnu::always_inline]] void mask(const vec<T, Bytes> &x, vec<lane_int<T>, Bytes> &m) const {
+            inner.template mask<T, Bytes>(x, m);
+            m = ~m;
+        }
+    };
+
+    template<typename V>
+    Compare<V, Greater> gt(V v) { return {v}; }
+
+    template<typename V>
+    Compare<V, GreaterEqual> ge(V v) { return {v}; }
+
+    template<typename V>
+    Compare<V, Less> lt(V v) { return {v}; }
+
+    template<typename V>
+    Compare<V, LessEqual> le(V v) { return {v}; }
+
+    template<typename V>
+    Compare<V, Equal> eq(V v) { return {v}; }
+
+    template<typename V>
+    Compare<V, NotEqual> ne(V v) { return {v}; }
+
+    template<typename V>
+    Between<V> between(V lo, V hi) { return {lo, hi}; }
+
+    template<Predicate L, Predicate R>
+    And<L, R> operator&&(const L &l, const R &r) { return {l, r}; }
+
+    template<Predicate L, Predicate R>
+    Or<L, R> operator||(const L &l, const R &r) { return {l, r}; }
+
+    template<Predicate P>
+    Not<P> operator!(const P &p) { return {p}; }
+
+    // the vector loops, instantiated for 16 bytes (baseline) and 32 (avx2) below
+    namespace detail {
+        // an unaligned vector load
+        template<typename T, int Bytes>
+        [[gnu::always_inline]] inline void load(vec<T, Bytes> &v, const T *p) {
+            memcpy(&v, p, Bytes);
+        }
+
+        template<typename T, int Bytes, typename P>
+        [[gnu::always_inline]] inline long count(const T *p, long n, const P &pred) {
+            constexpr long lanes = Bytes / sizeof(T);
+            // the per-lane counters are as narrow as the elements: flush them before they can overflow
+            constexpr long max_rounds = sizeof(T) == 1 ? 127 : sizeof(T) == 2 ? 32767 : 1L << 30;
+            using I = lane_int<T>;
+            long total = 0, i = 0;
+            while (n - i >= lanes) {
+                long rounds = min((n - i) / lanes, max_rounds);
+                vec<I, Bytes> counters {};
+                for (long r = 0; r != rounds; ++r, i += lanes) {
+                    vec<T, Bytes> x;
+                    vec<I, Bytes> m;
+                    load<T, Bytes>(x, p + i);
+                    pred.template mask<T, Bytes>(x, m);
+                    counters -= m; // a passing lane is -1
+                }
+                for (long l = 0; l != lanes; ++l) {
+                    total += counters[l];
+                }
+            }
+            for (; i != n; ++i) {
+                total += pred(p[i]);
+            }
+            return total;
+        }
+
+        template<typename T, int Bytes, typename P>
+        [[gnu::always_inline]] inline long find(const T *p, long n, const P &pred) {
+            constexpr long lanes = Bytes / sizeof(T);
+            long i = 0;
+            for (; i + lanes <= n; i += lanes) {
+                vec<T, Bytes> x;
+                vec<lane_int<T>, Bytes> m;
+                load<T, Bytes>(x, p + i);
+                pred.template mask<T, Bytes>(x, m);
+                vec<int64_t, Bytes> any; // is any lane set? Checked 8 bytes at a time
+                memcpy(&any, &m, Bytes);
+                bool hit = false;
+                for (long w = 0; w != Bytes / 8; ++w) {
+                    hit |= any[w] != 0;
+                }
+                if (hit) {
+                    for (long l = 0;; ++l) {
+                        if (m[l]) {
+                            return i + l;
+                        }
+                    }
+                }
+            }
+            for (; i != n; ++i) {
+                if (pred(p[i])) {
+                    return i;
+                }
+            }
+            return n;
+        }
+
+#ifdef BRAINTRAIN_X86
+        template<typename T, typename P>
+        __attribute__((target("avx2"))) long count_avx2(const T *p, long n, const P &pred) {
+            return count<T, 32>(p, n, pred);
+        }
+
+        template<typename T, typename P>
+        __attribute__((target("avx2"))) long find_avx2(const T *p, long n, const P &pred) {
+            return find<T, 32>(p, n, pred);
+        }
+#endif
+
+        // the loops are templates over every element and predicate type, so there is no table of kernels to hand to a
+        // cpu::Dispatch: just the level, avx2 (32 bytes) or the 16-byte baseline
+        inline atomic<cpu::Isa> &level() {
+            static atomic<cpu::Isa> isa {cpu::supports(cpu::Isa::avx2) ? cpu::Isa::avx2 : cpu::Isa::sse2};
+            return isa;
+        }
+
+        inline bool wide() {
+#ifdef BRAINTRAIN_X86
+            return level().load(memory_order_relaxed) == cpu::Isa::avx2;
+#else
+            return false;
+#endif
+        }
+
+        // a predicate of this header bound to the element type once (not per element), anything else as it is
+        template<typename E, typename P>
+        auto bound_to(const P &pred) {
+            if constexpr (Predicate<P> && is_arithmetic_v<E> && !is_same_v<E, bool>) {
+                return pred.template bind<E>();
+            } else {
+                return pred;
+            }
+        }
+
+        template<typename R>
+        concept arithmetic_array = ranges::contiguous_range<R> && is_arithmetic_v<ranges::range_value_t<R>> &&
+                                   !is_same_v<ranges::range_value_t<R>, bool>;
+    }
+
+    // the level the loops run with (to put it back after a use_isa)
+    inline cpu::Isa active_isa() {
+        return detail::level().load(memory_order_relaxed);
+    }
+
+    // force the 16-byte loops (sse2, for timing them on an avx2 machine) or go back to avx2; clamped to what the cpu runs.
+    // returns the level in use afterwards. Safe while other threads are counting
+    inline cpu::Isa use_isa(cpu::Isa wanted) {
+        cpu::Isa isa = wanted >= cpu::Isa::avx2 && cpu::supports(cpu::Isa::avx2) ? cpu::Isa::avx2 : cpu::Isa::sse2;
+        detail::level().store(isa, memory_order_relaxed);
+        return isa;
+    }
+
+    // how many elements pass. Vectorized for a predicate of this header over a contiguous array of numbers
+    template<typename T, Predicate P>
+    long count_if(const T *p, long n, const P &pred) {
+        auto bound = pred.template bind<T>();
+        if (!bound.plain()) {
+            long total = 0;
+            for (long i = 0; i != n; ++i) {
+                total += bound(p[i]);
+            }
+            return total;
+        }
+#ifdef BRAINTRAIN_X86
+        if (detail::wide()) {
+            return detail::count_avx2(p, n, bound);
+        }
+#endif
+        return detail::count<T, 16>(p, n, bound);
+    }
+
+    // the index of the first element that passes, n when there is none
+    template<typename T, Predicate P>
+    long find_if(const T *p, long n, const P &pred) {
+        auto bound = pred.template bind<T>();
+        if (!bound.plain()) {
+            long i = 0;
+            while (i != n && !bound(p[i])) {
+                ++i;
+            }
+            return i;
+        }
+#ifdef BRAINTRAIN_X86
+        if (detail::wide()) {
+            return detail::find_avx2(p, n, bound);
+        }
+#endif
+        return detail::find<T, 16>(p, n, bound);
+    }
+
+    template<typename R, typename P>
+    long count_if(R &&r, const P &pred) {
+        if constexpr (Predicate<P> && detail::arithmetic_array<R>) {
+            return count_if(ranges::data(r), static_cast<long>(ranges::size(r)), pred);
+        } else {
+            auto test = detail::bound_to<ranges::range_value_t<R>>(pred);
+            long count = 0;
+            for (const auto &elem : r) {
+                count += static_cast<bool>(test(elem)); // still no branch
+            }
+            return count;
+        }
+    }
+
+    // the position of the first element that passes, as a distance from the start (the size when there is none)
+    template<typename R, typename P>
+    long find_if(R &&r, const P &pred) {
+        if constexpr (Predicate<P> && detail::arithmetic_array<R>) {
+            return find_if(ranges::data(r), static_cast<long>(ranges::size(r)), pred);
+        } else {
+            auto test = detail::bound_to<ranges::range_value_t<R>>(pred);
+            long i = 0;
+            for (const auto &elem : r) {
+                if (test(elem)) {
+                    return i;
+                }
+                ++i;
+            }
+            return i;
+        }
+    }
+}
+
+#endif //BRAINTRAIN_PREDICATES_H
@@ -3,7 +3,8 @@
 
 #include "Vehicle.h"
 
-class Sedan : public Vehicle {
+// final for the same reason as Truck
+class Sedan final : public Vehicle {
 public:
     Sedan(int, int);
 
@@ -0,0 +1,210 @@
+#ifndef BRAINTRAIN_STATICVECTOR_H
+#define BRAINTRAIN_STATICVECTOR_H
+
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+// value template args are permitted and it allows creating containers statically w/o accessing the heap (this grew out of
+// template_struct<T, N> in riemann.cpp, which only knew its N).
+// StaticVector<T, N> has room for N elements inside the object and never allocates: the capacity is fixed, pushing into a
+// full one throws length_error (or use try_emplace_back where that is an expected case). Unlike TVector<T, N> there is no
+// heap to spill to, so no pointer to chase and no branch on inline vs heap.
+// Everything is constexpr, so one can be filled and read during compilation (check the static_assert in riemann.cpp).
+template<typename T, int N>
+class StaticVector {
+    static_assert(N >= 0, "capacity cannot be negative");
+private:
+    // a union so the elements are not constructed along with the object (T does not need a default cntr and nothing is
+    // zeroed); the first length of them are alive
+    union Storage {
+        T items[N > 0 ? N : 1];
+
+        constexpr Storage() {}
+
+        constexpr ~Storage() {}
+    };
+
+    int length = 0;
+    Storage storage;
+
+    constexpr T *at_slot(int i) noexcept { return storage.items + i; }
+
+    // a constexpr variable must be fully initialized, the slots past length included. At runtime they are left alone
+    constexpr void init_for_constant_evaluation() noexcept {
+        if constexpr (is_trivially_default_constructible_v<T>) {
+            if (is_constant_evaluated()) {
+                for (int i = 0; i != N; i++) {
+                    construct_at(at_slot(i));
+                }
+            }
+        }
+    }
+
+    // nothing to run for ints and the like (and ending their lifetime would leave a hole in a constexpr variable)
+    constexpr void destroy_slot(int i) noexcept {
+        if constexpr (!is_trivially_destructible_v<T>) {
+            destroy_at(at_slot(i));
+        }
+    }
+
+    constexpr void check_room() const {
+        if (length == N) {
+            throw length_error("StaticVector is full: capacity " + to_string(N));
+        }
+    }
+
+    // for the constructors: the destructor does not run when a constructor throws, so the elements already made are
+    // destroyed here before the exception leaves
+    template<typename It>
+    constexpr void append_all(It first, It last) {
+        try {
+            for (; first != last; ++first) {
+                construct_at(at_slot(length), *first);
+                length++;
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+public:
+    using value_type = T; // alias type T to value_type (used in all std::collections)
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    constexpr StaticVector() noexcept { init_for_constant_evaluation(); }
+
+    constexpr StaticVector(initializer_list<T> init) {
+        init_for_constant_evaluation();
+        if (static_cast<int>(init.size()) > N) {
+            throw length_error(to_string(init.size()) + " elements do not fit in a StaticVector of " + to_string(N));
+        }
+        append_all(init.begin(), init.end());
+    }
+
+    constexpr StaticVector(const StaticVector &v) {
+        init_for_constant_evaluation();
+        append_all(v.begin(), v.end());
+    }
+
+    // the elements are moved one by one (there is no pointer to steal); the source keeps its (moved-from) elements
+    constexpr StaticVector(StaticVector &&v) noexcept(is_nothrow_move_constructible_v<T>) {
+        init_for_constant_evaluation();
+        append_all(make_move_iterator(v.begin()), make_move_iterator(v.end()));
+    }
+
+    constexpr StaticVector &operator=(const StaticVector &v) {
+        if (&v != this) {
+            assign_from(v);
+        }
+        return *this;
+    }
+
+    constexpr StaticVector &operator=(StaticVector &&v) noexcept(is_nothrow_move_assignable_v<T> && is_nothrow_move_constructible_v<T>) {
+        if (&v != this) {
+            assign_from(std::move(v));
+        }
+        return *this;
+    }
+
+    constexpr ~StaticVector() { clear(); }
+
+    [[nodiscard]] constexpr int get_size() const noexcept { return length; }
+
+    [[nodiscard]] static constexpr int capacity() noexcept { return N; }
+
+    [[nodiscard]] constexpr bool empty() const noexcept { return length == 0; }
+
+    [[nodiscard]] constexpr bool full() const noexcept { return length == N; }
+
+    constexpr void push_back(const T &v) { emplace_back(v); }
+
+    constexpr void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    template<typename... Args>
+    constexpr T &emplace_back(Args &&... args) {
+        check_room();
+        T *slot = construct_at(at_slot(length), std::forward<Args>(args)...);
+        length++;
+        return *slot;
+    }
+
+    // for the hot paths where running out of room is expected: nullptr when full instead of an exception
+    template<typename... Args>
+    constexpr T *try_emplace_back(Args &&... args) {
+        if (length == N) {
+            return nullptr;
+        }
+        T *slot = construct_at(at_slot(length), std::forward<Args>(args)...);
+        length++;
+        return slot;
+    }
+
+    constexpr void pop_back() {
+        if (length == 0) {
+            throw out_of_range("pop_back on an empty StaticVector");
+        }
+        length--;
+        destroy_slot(length);
+    }
+
+    constexpr void clear() noexcept {
+        for (; length > 0; length--) {
+            destroy_slot(length - 1);
+        }
+    }
+
+    // unchecked like TVector's
+    constexpr T &operator[](int i) { return storage.items[i]; }
+
+    constexpr const T &operator[](int i) const { return storage.items[i]; }
+
+    constexpr T &front() { return storage.items[0]; }
+
+    constexpr T &back() { return storage.items[length - 1]; }
+
+    constexpr T *data() noexcept { return storage.items; }
+
+    constexpr const T *data() const noexcept { return storage.items; }
+
+    constexpr T *begin() noexcept { return storage.items; }
+
+    constexpr T *end() noexcept { return storage.items + length; }
+
+    constexpr const T *begin() const noexcept { return storage.items; }
+
+    constexpr const T *end() const noexcept { return storage.items + length; }
+
+private:
+    // assign the elements both have, then construct or destroy the difference
+    template<typename V>
+    constexpr void assign_from(V &&v) {
+        int common = length < v.length ? length : v.length;
+        for (int i = 0; i != common; i++) {
+            if constexpr (is_rvalue_reference_v<V &&>) {
+                storage.items[i] = std::move(v.storage.items[i]);
+            } else {
+                storage.items[i] = v.storage.items[i];
+            }
+        }
+        for (; length < v.length; length++) {
+            if constexpr (is_rvalue_reference_v<V &&>) {
+                construct_at(at_slot(length), std::move(v.storage.items[length]));
+            } else {
+                construct_at(at_slot(length), v.storage.items[length]);
+            }
+        }
+        while (length > v.length) {
+            length--;
+            destroy_slot(length);
+        }
+    }
+};
+
+#endif //BRAINTRAIN_STATICVECTOR_H
@@ -1,33 +1,131 @@
 #ifndef BRAINTRAIN_TVECTOR_H
 #define BRAINTRAIN_TVECTOR_H
 
-#include <iostream>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "../../common/headers/Lifecycle.h"
 using namespace std;
 
+// a type is trivially relocatable when moving it to a new address and forgetting the old copy is the same as memcpy-ing its
+// bytes. Every trivially copyable type is; specialize this for types that are but that the compiler cannot tell
+// (unique_ptr for example). std::string is NOT: with the small string optimization it can point into itself
 template<typename T>
+inline constexpr bool is_trivially_relocatable = is_trivially_copyable_v<T>;
+
+template<typename T, typename D>
+inline constexpr bool is_trivially_relocatable<unique_ptr<T, D>> = is_trivially_relocatable<D>;
+
+// raw (uninitialized) room for N elements inside the TVector object itself. The elements are constructed in it on demand
+template<typename T, int N>
+struct tvector_inline_storage {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+
+    T *data() { return reinterpret_cast<T *>(bytes); }
+
+    const T *data() const { return reinterpret_cast<const T *>(bytes); }
+};
+
+// no inline room: [[no_unique_address]] makes this take no space so TVector<T> stays a pointer and a length
+template<typename T>
+struct tvector_inline_storage<T, 0> {
+    T *data() { return nullptr; }
+
+    const T *data() const { return nullptr; }
+};
+
+// InlineN > 0 is the small-buffer optimization: up to InlineN elements live inside the object (no heap round-trip),
+// longer vectors spill to the heap. TVector<T> (InlineN = 0) always uses the heap like before.
+// Alloc is where the heap blocks come from and how the elements are constructed/destroyed (allocator_traits), same as
+// the std containers. std::allocator is stateless so [[no_unique_address]] makes it free
+template<typename T, int InlineN = 0, typename Alloc = std::allocator<T>>
 
 class TVector {
+    static_assert(InlineN >= 0, "inline capacity cannot be negative");
+    using alloc_traits = allocator_traits<Alloc>;
+    // moving from a vector whose allocator we cannot take over (pmr with a different resource) has to move element by element
+    static constexpr bool move_assign_steals = alloc_traits::propagate_on_container_move_assignment::value ||
+                                               alloc_traits::is_always_equal::value;
 private:
     int length;
-    T *items;
+    int cap; // elements that fit in items before we have to reallocate (InlineN when inline)
+    T *items; // points at inline_buf when the elements fit in it, at a heap block otherwise
+    [[no_unique_address]] tvector_inline_storage<T, InlineN> inline_buf;
+    [[no_unique_address]] Alloc alloc;
+
+    T *allocate(int); // raw memory only: the callers construct the elements. Sets cap
+
+    void deallocate(T *, int) noexcept; // no-op for the inline buffer
+
+    void relocate(T *, int, T *); // moves n elements to uninitialized memory and destroys the originals
+
+    void reallocate(int); // moves the elements to a block of (at least) the given capacity
+
+    void release() noexcept; // destroys the elements and frees the heap block (if any)
+
+    // stealing a heap block is a pointer swap, but inline elements are moved one by one (or copied, when their move can
+    // throw and they have a copy-cntr): then only a T that moves without throwing keeps the move noexcept. A function
+    // rather than a constant so T only has to be complete once a move is used (a struct can hold a TVector of itself)
+    static constexpr bool nothrow_steal() {
+        if constexpr (InlineN == 0) {
+            return true;
+        } else {
+            return is_trivially_relocatable<T> || is_nothrow_move_constructible_v<T>;
+        }
+    }
+
+    void steal(TVector&&) noexcept(nothrow_steal()); // the guts of the move-cntr/assign: v's allocator must be equal to ours
 public:
-    explicit TVector(int); // no implicit conversion from int to vector
+    using allocator_type = Alloc;
+
+    TVector(); // empty - the way to start a vector that is filled with push_back (T does not need a default cntr)
+
+    explicit TVector(const Alloc&); // empty with the given allocator (a pmr allocator pointing at a request arena for example)
 
-    TVector(std::initializer_list<T>);
+    explicit TVector(int, const Alloc& = Alloc()); // no implicit conversion from int to vector
+
+    TVector(std::initializer_list<T>, const Alloc& = Alloc());
 
     TVector(const TVector&); //copy-cntr
 
-    TVector(TVector&&) noexcept; // move-cntr
+    TVector(const TVector&, const Alloc&); // copy into another arena
+
+    TVector(TVector&&) noexcept(nothrow_steal()); // move-cntr
 
     ~TVector();
 
     TVector &operator=(const TVector&); // copy assignment
 
-    TVector &operator=(TVector&&) noexcept; // move assignment
+    TVector &operator=(TVector&&) noexcept(move_assign_steals && nothrow_steal()); // move assignment
+
+    [[nodiscard]] Alloc get_allocator() const;
 
     // const signifies that this func doesn't modify its object. It can be called by const and non-const objects
     // however non-const funcs cannot be called by const objects (talk about simplicity!)
     [[nodiscard]] int get_size() const;
+
+    [[nodiscard]] int capacity() const;
+
+    // appending is amortized O(1): the capacity doubles when it runs out. On reallocation elements are relocated with
+    // memcpy when T is trivially relocatable, moved when T has a noexcept move-cntr, and copied otherwise (so a throwing
+    // copy leaves the vector as it was)
+    void push_back(const T&);
+
+    void push_back(T&&);
+
+    template<typename... Args>
+    T &emplace_back(Args&&...); // construct in place from the cntr args (no temporary T)
+
+    void reserve(int); // grow the capacity up front when the final size is known; never shrinks
+
+    void shrink_to_fit(); // give back the unused capacity (moves back inline if the elements fit)
+
+    // true when the elements live inside the object (never the case for InlineN = 0 unless the vector is empty)
+    [[nodiscard]] bool is_inline() const;
+
     // note the way B.S. implemented this is to pass TVector& but it did not work.. same for end (I think he made a mistake)
     T* begin() const;
 
@@ -39,96 +137,316 @@ public:
     const T &operator[](int) const;
 };
 
+// a TVector whose memory comes from a std::pmr::memory_resource picked at runtime: back it with a monotonic_buffer_resource
+// per request and all the vectors of the request are freed at once when the arena goes away (deallocate is a no-op there).
+// (not called pmr::TVector: with 'using namespace std' all over the place pmr:: would be ambiguous)
+template<typename T, int InlineN = 0>
+using PmrTVector = TVector<T, InlineN, std::pmr::polymorphic_allocator<T>>;
+
 // template implementation must be in the header file
 
-template<typename T>
-TVector<T>::TVector(int len) {
-    cout << "TVector-conversion-cntr is called" << endl;
-    if (len < 0) {
-        throw length_error("negative vector length: " + to_string(len));
+template<typename T, int InlineN, typename Alloc>
+T *TVector<T, InlineN, Alloc>::allocate(int len) {
+    if (len <= InlineN) {
+        cap = InlineN;
+        return inline_buf.data();
     }
-    length = len;
-    items = new T[len];
+    T *block = alloc_traits::allocate(alloc, len);
+    lifecycle::allocated<TVector>(static_cast<long>(len) * sizeof(T));
+    cap = len;
+    return block;
 }
 
-template<typename T>
-TVector<T>::TVector(initializer_list<T> init): length {static_cast<int>(init.size())}, items{new T[length]} {
-    cout << "TVector-initializer-list-cntr is called" << endl;
-    copy(init.begin(), init.end(), items);
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::deallocate(T *block, int block_cap) noexcept {
+    if (block != inline_buf.data()) {
+        alloc_traits::deallocate(alloc, block, block_cap);
+    }
 }
 
-template<typename T>
-TVector<T>::TVector(const TVector<T> & v): length {v.length}, items {new T[v.length]} {
-    cout << "TVector-copy-cntr is called" << endl;
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::relocate(T *from, int n, T *to) {
+    if constexpr (is_trivially_relocatable<T>) {
+        if (n > 0) {
+            memcpy(static_cast<void *>(to), static_cast<const void *>(from), n * sizeof(T));
+        }
+        return;
+    }
+    int done = 0;
+    try {
+        for (; done != n; ++done) {
+            if constexpr (is_nothrow_move_constructible_v<T> || !is_copy_constructible_v<T>) {
+                alloc_traits::construct(alloc, to + done, std::move(from[done]));
+            } else {
+                alloc_traits::construct(alloc, to + done, from[done]); // if this throws the originals are still intact
+            }
+        }
+    } catch (...) {
+        for (int i = 0; i != done; ++i) {
+            alloc_traits::destroy(alloc, to + i);
+        }
+        throw;
+    }
+    for (int i = 0; i != n; ++i) {
+        alloc_traits::destroy(alloc, from + i);
+    }
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::reallocate(int new_cap) {
+    T *old = items;
+    int old_cap = cap;
+    T *fresh = allocate(new_cap);
+    try {
+        relocate(old, length, fresh);
+    } catch (...) {
+        deallocate(fresh, cap);
+        cap = old_cap;
+        throw;
+    }
+    deallocate(old, old_cap);
+    items = fresh;
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::release() noexcept {
     for (int i = 0; i != length; ++i) {
-        items[i] = v.items[i];
+        alloc_traits::destroy(alloc, items + i);
     }
+    deallocate(items, cap);
+    items = inline_buf.data();
+    cap = InlineN;
+    length = 0;
 }
 
-template<typename T>
-TVector<T>::TVector(TVector<T> &&v) noexcept: length {v.length}, items {v.items} { // move cntr
-    cout << "TVector-move-cntr is called" << endl;
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::steal(TVector<T, InlineN, Alloc> &&v) noexcept(nothrow_steal()) {
+    if (v.is_inline()) {
+        // inline elements cannot change hands with a pointer swap: they have to be moved one by one into our buffer
+        items = inline_buf.data();
+        relocate(v.items, v.length, items);
+    } else {
+        items = v.items;
+    }
+    length = v.length;
+    cap = v.cap;
     v.length = 0;
-    v.items = nullptr;
+    v.cap = InlineN;
+    v.items = v.inline_buf.data();
 }
 
-template<typename T>
-TVector<T> &TVector<T>::operator=(TVector<T> &&v) noexcept { // move-assignment
-    cout << "TVector-move-assign is called" << endl;
-    delete [] items;
-    length = v.length;
-    items = v.items;
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(): TVector(Alloc()) {}
 
-    v.length = 0;
-    v.items = nullptr;
-    return *this;
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(const Alloc &a): length {0}, cap {InlineN}, alloc {a} {
+    lifecycle::constructed<TVector>();
+    items = inline_buf.data();
 }
 
-template<typename T>
-TVector<T> &TVector<T>::operator=(const TVector<T> &v) { // copy-assignment
-    cout << "TVector-copy-assign is called" << endl;
-    if (v == this) {
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(int len, const Alloc &a): length {0}, alloc {a} {
+    if (len < 0) {
+        throw length_error("negative vector length: " + to_string(len));
+    }
+    items = allocate(len);
+    try {
+        for (; length != len; ++length) {
+            alloc_traits::construct(alloc, items + length); // value-initialized: strings are empty, ints are 0
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+    lifecycle::constructed<TVector>();
+}
+
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(initializer_list<T> init, const Alloc &a): length {0}, alloc {a} {
+    items = allocate(static_cast<int>(init.size()));
+    try {
+        for (const T &val : init) {
+            alloc_traits::construct(alloc, items + length, val);
+            ++length;
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+    lifecycle::constructed<TVector>();
+}
+
+// pmr allocators do not follow the copy: select_on_container_copy_construction hands back the default resource
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(const TVector<T, InlineN, Alloc> &v):
+        TVector(v, alloc_traits::select_on_container_copy_construction(v.alloc)) {}
+
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(const TVector<T, InlineN, Alloc> &v, const Alloc &a): length {0}, alloc {a} {
+    items = allocate(v.length);
+    try {
+        for (; length != v.length; ++length) {
+            alloc_traits::construct(alloc, items + length, v.items[length]);
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+    lifecycle::copied<TVector>();
+}
+
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::TVector(TVector<T, InlineN, Alloc> &&v) noexcept(nothrow_steal()): alloc {std::move(v.alloc)} { // move cntr
+    lifecycle::moved<TVector>();
+    steal(std::move(v));
+}
+
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc> &TVector<T, InlineN, Alloc>::operator=(TVector<T, InlineN, Alloc> &&v) noexcept(move_assign_steals && nothrow_steal()) { // move-assignment
+    if (&v == this) {
         return *this;
     }
-    T* old = items;
+    lifecycle::move_assigned<TVector>();
+    release();
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+        alloc = std::move(v.alloc);
+    }
+    if (move_assign_steals || alloc == v.alloc) {
+        steal(std::move(v));
+    } else {
+        // v's block belongs to another arena: move its elements into memory of our own
+        reserve(v.length);
+        for (T &val : v) {
+            emplace_back(std::move(val));
+        }
+        v.release();
+    }
+    return *this;
+}
 
-    items = new T[v.length];
-    length = v.length;
-    for (int i = 0; i < v.length; i++) {
-        items[i] = v.items[i];
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc> &TVector<T, InlineN, Alloc>::operator=(const TVector<T, InlineN, Alloc> &v) { // copy-assignment
+    if (&v == this) {
+        return *this;
+    }
+    lifecycle::copy_assigned<TVector>();
+    // like std::vector this gives the basic guarantee only: if copying an element throws we are left empty (but valid).
+    // (copying into a temporary and stealing it would show up as an extra copy+destroy in the lifecycle counts)
+    release();
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+        alloc = v.alloc;
+    }
+    items = allocate(v.length);
+    try {
+        for (; length != v.length; ++length) {
+            alloc_traits::construct(alloc, items + length, v.items[length]);
+        }
+    } catch (...) {
+        release();
+        throw;
     }
-    delete [] old;
     return *this;
 }
 
-template<typename T>
-TVector<T>::~TVector() {
-    cout << "TVector-destructor is called" << endl;
-    delete [] items; // plain delete deletes a single object, delete[] deletes the array
+template<typename T, int InlineN, typename Alloc>
+TVector<T, InlineN, Alloc>::~TVector() {
+    lifecycle::destroyed<TVector>();
+    release();
 }
 
-template<typename T>
-int TVector<T>::get_size() const {
+template<typename T, int InlineN, typename Alloc>
+Alloc TVector<T, InlineN, Alloc>::get_allocator() const {
+    return alloc;
+}
+
+template<typename T, int InlineN, typename Alloc>
+int TVector<T, InlineN, Alloc>::get_size() const {
     return length;
 }
 
-template<typename T>
-T* TVector<T>::begin() const {
+template<typename T, int InlineN, typename Alloc>
+int TVector<T, InlineN, Alloc>::capacity() const {
+    return cap;
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::push_back(const T &val) {
+    emplace_back(val);
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::push_back(T &&val) {
+    emplace_back(std::move(val));
+}
+
+template<typename T, int InlineN, typename Alloc>
+template<typename... Args>
+T &TVector<T, InlineN, Alloc>::emplace_back(Args &&... args) {
+    if (length < cap) {
+        alloc_traits::construct(alloc, items + length, std::forward<Args>(args)...);
+        return items[length++];
+    }
+    // full: build the new element in the new block *before* relocating the old ones since args may refer to one of them
+    // (v.push_back(v[0]))
+    T *old = items;
+    int old_cap = cap;
+    T *fresh = allocate(cap ? 2 * cap : 4);
+    try {
+        alloc_traits::construct(alloc, fresh + length, std::forward<Args>(args)...);
+    } catch (...) {
+        deallocate(fresh, cap);
+        cap = old_cap;
+        throw;
+    }
+    try {
+        relocate(old, length, fresh);
+    } catch (...) {
+        alloc_traits::destroy(alloc, fresh + length);
+        deallocate(fresh, cap);
+        cap = old_cap;
+        throw;
+    }
+    deallocate(old, old_cap);
+    items = fresh;
+    return items[length++];
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::reserve(int new_cap) {
+    if (new_cap > cap) {
+        reallocate(new_cap);
+    }
+}
+
+template<typename T, int InlineN, typename Alloc>
+void TVector<T, InlineN, Alloc>::shrink_to_fit() {
+    if (cap > length && !is_inline()) {
+        reallocate(length); // allocate() hands back the inline buffer when length <= InlineN
+    }
+}
+
+template<typename T, int InlineN, typename Alloc>
+bool TVector<T, InlineN, Alloc>::is_inline() const {
+    return items == inline_buf.data();
+}
+
+template<typename T, int InlineN, typename Alloc>
+T* TVector<T, InlineN, Alloc>::begin() const {
     return length ? &items[0] : nullptr;
 }
 
-template<typename T>
-T* TVector<T>::end() const {
+template<typename T, int InlineN, typename Alloc>
+T* TVector<T, InlineN, Alloc>::end() const {
     return length ? &items[length] : nullptr;
 }
 
-template<typename T>
-T &TVector<T>::operator[](int i) {
+template<typename T, int InlineN, typename Alloc>
+T &TVector<T, InlineN, Alloc>::operator[](int i) {
     return items[i];
 }
 
-template<typename T>
-const T &TVector<T>::operator[](int i) const {
+template<typename T, int InlineN, typename Alloc>
+const T &TVector<T, InlineN, Alloc>::operator[](int i) const {
     return items[i];
 }
 
@@ -3,7 +3,8 @@
 
 #include "Vehicle.h"
 
-class Truck : public Vehicle {
+// final: nothing derives from it, so a call thru a Truck& (a PolyCollection segment) is a direct call, not a virtual one
+class Truck final : public Vehicle {
 public:
     Truck(int, int);
 
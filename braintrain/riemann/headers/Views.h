@@ -0,0 +1,176 @@
+#ifndef BRAINTRAIN_VIEWS_H
+#define BRAINTRAIN_VIEWS_H
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+// non-owning views: a pointer and a length (and a stride) into somebody else's buffer. Making one costs nothing and copies
+// nothing, so a window over a big buffer is not a new TVector like pass_typed_vector builds. A view does not keep its
+// buffer alive: it dangles once the vector it was taken from is destroyed or reallocates (push_back past the capacity)
+
+// anything that hands out its elements as a pointer and knows its length: TVector, StaticVector, MappedVector, Vector3
+template<typename C>
+concept contiguous_buffer = requires(C &c) {
+    { c.begin() } -> convertible_to<const volatile void *>;
+    { c.get_size() } -> convertible_to<long>;
+};
+
+template<contiguous_buffer C>
+using buffer_element = remove_reference_t<decltype(*declval<C &>().begin())>;
+
+inline void check_view(long first, long count, long stride, long size) {
+    // the last element viewed is first + (count - 1) * stride: it and first must both be inside the buffer
+    long last = count ? first + (count - 1) * stride : first;
+    if (count < 0 || first < 0 || last < 0 || (count && (first >= size || last >= size)) || first > size) {
+        throw out_of_range("view of " + to_string(count) + " elements from " + to_string(first) + " by " + to_string(stride) +
+                           " outside a buffer of " + to_string(size));
+    }
+}
+
+// a contiguous run of elements. begin() is a plain pointer so it is a contiguous range (func_template1 sums it pairwise)
+template<typename T>
+class Slice {
+private:
+    T *first;
+    long length;
+public:
+    Slice(): first {nullptr}, length {0} {}
+
+    Slice(T *p, long n): first {p}, length {n} {}
+
+    [[nodiscard]] long get_size() const { return length; }
+
+    T *begin() const { return first; }
+
+    T *end() const { return first + length; }
+
+    T *data() const { return first; }
+
+    T &operator[](long i) const { return first[i]; } // unchecked like TVector
+
+    Slice subslice(long from, long count) const {
+        check_view(from, count, 1, length);
+        return {first + from, count};
+    }
+};
+
+// every stride-th element: a column of a row-major matrix, one channel of interleaved audio... A negative stride walks
+// backwards (reversed() below). The iterator keeps an index rather than a pointer so end() never points outside the buffer
+template<typename T>
+class Strided {
+private:
+    T *first;
+    long length;
+    long step;
+public:
+    class iterator {
+    private:
+        T *base;
+        long step;
+        long i;
+    public:
+        using iterator_category = random_access_iterator_tag;
+        using value_type = remove_cv_t<T>;
+        using difference_type = ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        iterator(): base {nullptr}, step {1}, i {0} {}
+
+        iterator(T *b, long s, long at): base {b}, step {s}, i {at} {}
+
+        T &operator*() const { return base[i * step]; }
+
+        T *operator->() const { return base + i * step; }
+
+        T &operator[](difference_type n) const { return base[(i + n) * step]; }
+
+        iterator &operator++() {
+            ++i;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++i;
+            return old;
+        }
+
+        iterator &operator--() {
+            --i;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator old = *this;
+            --i;
+            return old;
+        }
+
+        iterator &operator+=(difference_type n) {
+            i += n;
+            return *this;
+        }
+
+        iterator &operator-=(difference_type n) {
+            i -= n;
+            return *this;
+        }
+
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+
+        friend difference_type operator-(const iterator &a, const iterator &b) { return a.i - b.i; }
+
+        friend bool operator==(const iterator &a, const iterator &b) { return a.i == b.i; }
+
+        friend auto operator<=>(const iterator &a, const iterator &b) { return a.i <=> b.i; }
+    };
+
+    Strided(): first {nullptr}, length {0}, step {1} {}
+
+    Strided(T *p, long n, long s): first {p}, length {n}, step {s} {}
+
+    [[nodiscard]] long get_size() const { return length; }
+
+    [[nodiscard]] long stride() const { return step; }
+
+    iterator begin() const { return {first, step, 0}; }
+
+    iterator end() const { return {first, step, length}; }
+
+    T &operator[](long i) const { return first[i * step]; } // unchecked like TVector
+};
+
+// the factories check the range against the buffer (out_of_range) so the views themselves never have to
+
+template<contiguous_buffer C>
+Slice<buffer_element<C>> slice(C &c, long first, long count) {
+    check_view(first, count, 1, c.get_size());
+    return {c.begin() + first, count};
+}
+
+template<contiguous_buffer C>
+Strided<buffer_element<C>> strided(C &c, long first, long count, long stride) {
+    if (stride == 0) {
+        throw invalid_argument("a view needs a non-zero stride");
+    }
+    check_view(first, count, stride, c.get_size());
+    return {c.begin() + first, count, stride};
+}
+
+// last to first
+template<contiguous_buffer C>
+Strided<buffer_element<C>> reversed(C &c) {
+    long n = c.get_size();
+    return {c.begin() + (n ? n - 1 : 0), n, -1};
+}
+
+#endif //BRAINTRAIN_VIEWS_H
@@ -1,8 +1,20 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <complex>
+#include <filesystem>
 #include <memory>
+#include <memory_resource>
+#include <random>
 #include <vector>
+#include "headers/StaticVector.h"
+#include "../faraday/headers/Summation.h"
 #include "headers/TVector.h"
+#include "headers/MappedVector.h"
+#include "headers/Views.h"
+#include "headers/PolyCollection.h"
+#include "headers/Predicates.h"
+#include "headers/FleetTable.h"
 #include "headers/Vehicle.h"
 #include "headers/Truck.h"
 #include "headers/Sedan.h"
@@ -29,6 +41,21 @@ void work_with_custom_typed_vector() {
     cout << "v2[0] = " << v2[0] << " - v2[1] = " << v2[1] << endl;
 }
 
+// TVector<T, N> keeps up to N elements inside the object itself: no heap allocation for the tiny vectors we use everywhere
+void small_buffer_vector() {
+    cout << "small_buffer_vector" << endl;
+    TVector<string, 4> small = {"fits", "inline"};
+    TVector<string, 4> big = {"this", "one", "spills", "to", "heap"};
+    cout << "small inline: " << small.is_inline() << " - big inline: " << big.is_inline() << endl;
+
+    TVector<string, 4> moved = std::move(small); // inline elements are moved one by one (the pointer cannot be stolen)
+    TVector<string, 4> copied = big;
+    cout << moved[0] << " " << moved[1] << " - " << copied[2] << " - moved-from size: " << small.get_size() << endl;
+
+    copied = moved; // the copy now fits inline so its heap block is freed
+    cout << "copied inline: " << copied.is_inline() << " - " << copied[1] << endl;
+}
+
 void deduce_template_args() {
     cout << "deduce_template_args" << endl;
     pair<string, int> p1 = {"US", 1}; // explicitly specify pair arg types
@@ -49,10 +76,17 @@ void deduce_template_args() {
 template <typename T, typename V>
 V func_template1(T& seq, V v) { //2nd param specifies initial val
     cout << "func_template1" << endl;
-    for (auto elem : seq) {
-        v += elem;
+    // a contiguous sequence of V (vector, TVector, initializer_list...) is summed pairwise (check faraday/headers/Summation.h):
+    // the error of the plain loop grows with the length. Anything else still goes thru the loop. One thread: the result
+    // must not depend on how many cores the machine has
+    if constexpr (ranges::contiguous_range<T> && is_same_v<ranges::range_value_t<T>, V>) {
+        return v + summation::sum(seq, summation::Method::pairwise, 1);
+    } else {
+        for (auto elem : seq) {
+            v += elem;
+        }
+        return v;
     }
-    return v;
 }
 
 void func_template1_caller() {
@@ -67,6 +101,50 @@ void func_template1_caller() {
     cout << func_template1(v3, complex{0.0, 0.0}) << endl;
 }
 
+// TVector can grow now: the capacity doubles when it runs out so appending is amortized O(1)
+void growable_vector() {
+    cout << "growable_vector" << endl;
+    TVector<string, 2> names;
+    names.reserve(3);
+    names.push_back("Truck");
+    names.emplace_back(5, 'x'); // constructs the string "xxxxx" in place
+    string sedan = "Sedan";
+    names.push_back(std::move(sedan));
+    names.push_back(names[0]); // growing while pushing one of our own elements is fine
+    cout << "size: " << names.get_size() << " - capacity: " << names.capacity() << endl;
+    for (auto &name : names) {
+        cout << name << ", ";
+    }
+    cout << endl;
+
+    TVector<int> ids;
+    for (int i = 0; i != 100; i++) {
+        ids.push_back(i); // ints are trivially relocatable: each reallocation is a single memcpy
+    }
+    ids.shrink_to_fit();
+    int sum = func_template1(ids, 0);
+    cout << "ids: " << ids.get_size() << "/" << ids.capacity() << " - sum = " << sum << endl;
+}
+
+// PmrTVector takes its memory from a memory_resource picked at runtime: one arena per 'request' and the thousands of
+// short-lived vectors of the request are freed together when it goes out of scope
+void pmr_vectors() {
+    cout << "pmr_vectors" << endl;
+    pmr::monotonic_buffer_resource arena; // grows by grabbing big chunks from the heap, never frees before it is destroyed
+
+    PmrTVector<pmr::string> names {&arena};
+    for (int i = 0; i != 5; i++) {
+        // pmr::string elements get the arena too (allocator_traits::construct passes it along) so their characters do not
+        // go to the heap either
+        names.emplace_back("request-entity-with-a-long-name-" + to_string(i));
+    }
+    PmrTVector<int, 4> ids({1, 2, 3}, &arena);
+    PmrTVector<int, 4> other_ids; // default resource (the heap)
+    other_ids = std::move(ids); // different resources: elements are moved instead of stealing the arena's block
+    cout << names[4] << " - from arena: " << (names[4].get_allocator().resource() == &arena) << " - "
+         << other_ids[2] << endl;
+}
+
 // for a simple function object like this, inlining is simple, so a call of function objects is far more efficient than
 // an indirect function call. They are called policy objects as well
 template <typename T>
@@ -78,15 +156,11 @@ public:
     bool operator() (const T val) const { return val > t;} // func call operator()
 };
 
+// the count goes thru pred::count_if: a pred:: predicate over a contiguous array of numbers is counted a vector at a time,
+// anything else (like function_object_gt) by a loop that adds the bool instead of branching on it
 template <typename sequence, typename predicate>
 int count_using_func_obj(sequence &s, predicate p) {
-    int count = 0;
-    for (const auto &elem : s) {
-        if (p(elem)) {
-            count++;
-        }
-    }
-    return count;
+    return static_cast<int>(pred::count_if(s, p));
 }
 
 void count_using_func_obj_caller() {
@@ -95,17 +169,12 @@ void count_using_func_obj_caller() {
 //    function_object_gt<int> gt (2); // predicate - note that both type of initialization (2) or {2} work (the class init mess)
     function_object_gt<int> gt {2}; // predicate
     cout << count_using_func_obj(v, gt) << endl;
+    cout << count_using_func_obj(v, pred::gt(2)) << endl; // the same question, vectorized
 }
 
 template <typename sequence, typename lambda>
 int count_using_lambda(sequence &s, lambda lmda) {
-    int count = 0;
-    for (const auto &elem : s) {
-        if (lmda(elem)) {
-            count++;
-        }
-    }
-    return count;
+    return static_cast<int>(pred::count_if(s, lmda)); // a lambda is opaque: always the scalar loop
 }
 
 void lambda_expressions() {
@@ -133,13 +202,73 @@ void generic_lambda(vector<S>& v) {// this garbage must be a vector of pointers
     generic_lambda_callee(v, [](auto &elem) { return elem->imag();});
 }
 
-// value template args are permitted and it allows creating containers statically w/o accessing the heap
-template <typename T, int N>
-struct template_struct {
-    using value_type = T; // alias type T to value_type (used in all std::collections)
-    constexpr int size() { return N; }
-    // T[N]; //and this gives a compilation error: Decomposition declaration not permitted in this context
-};
+// value template args are permitted and it allows creating containers statically w/o accessing the heap: template_struct<T, N>
+// used to live here and only knew its N (T[N] as a member gave 'Decomposition declaration not permitted in this context').
+// It grew into StaticVector<T, N> (headers/StaticVector.h) which actually holds the elements
+
+// runs at compile time: the static_assert below fails the build if the answer is wrong
+constexpr int squares_below(int limit) {
+    StaticVector<int, 16> squares;
+    for (int i = 1; i * i < limit && !squares.full(); i++) {
+        squares.push_back(i * i);
+    }
+    int sum = 0;
+    for (int sq : squares) {
+        sum += sq;
+    }
+    return sum;
+}
+
+static_assert(squares_below(50) == 1 + 4 + 9 + 16 + 25 + 36 + 49);
+
+void static_vector() {
+    cout << "static_vector" << endl;
+    StaticVector<string, 4> names = {"no", "heap"};
+    names.emplace_back(3, '!');
+    cout << names.get_size() << "/" << names.capacity() << ": ";
+    for (const string &n : names) {
+        cout << n << " ";
+    }
+    cout << endl;
+
+    names.pop_back();
+    names.push_back("here");
+    names.push_back("either");
+    try {
+        names.push_back("one too many");
+    } catch (length_error &e) {
+        cout << "caught it: " << e.what() << endl;
+    }
+    cout << "try_emplace_back on a full one: " << (names.try_emplace_back("nope") == nullptr) << endl;
+}
+
+// a scratch list per packet: up to 8 offsets collected and summed then thrown away. std::vector goes to malloc for
+// every packet, StaticVector never does
+void scratch_list_benchmark() {
+    cout << "scratch_list_benchmark" << endl;
+    using namespace chrono;
+    const int packets = 2'000'000;
+
+    auto time_it = [&](const string &name, auto make_list) {
+        long checksum = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int p = 0; p != packets; p++) {
+            auto scratch = make_list();
+            for (int i = 0; i != 1 + p % 8; i++) {
+                scratch.push_back(p + i);
+            }
+            for (int off : scratch) {
+                checksum += off;
+            }
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, nano>(t2 - t1).count() / packets << " ns/packet (checksum " << checksum << ")" << endl;
+    };
+
+    time_it("std::vector", [] { return vector<int>(); });
+    time_it("TVector", [] { return TVector<int>(); });
+    time_it("StaticVector", [] { return StaticVector<int, 8>(); });
+}
 
 template<typename firstT, typename secondT>
 struct my_pair {
@@ -161,6 +290,15 @@ void vehicle_specs(vector<shared_ptr<Vehicle>> &vehicles) {
     }
 }
 
+using Fleet = PolyCollection<Vehicle, Truck, Sedan>;
+
+// the same specs off a fleet stored by value: the lambda is instantiated for Truck and for Sedan
+void vehicle_specs(const Fleet &fleet) {
+    fleet.for_each([](const auto &vehicle) {
+        cout << vehicle.top_speed() << " - " << vehicle.capacity() << endl;
+    });
+}
+
 void vehicle_specs_caller() {
     cout << "vehicle_specs_caller" << endl;
     shared_ptr<Vehicle> truck = make_unique<Truck>(100, 6); // note that I can make unique_ptr and assign to shared_ptr (not sure of rationale)
@@ -173,6 +311,62 @@ void vehicle_specs_caller() {
     vehicles.push_back(sedan);
 
     vehicle_specs(vehicles);
+
+    Fleet fleet;
+    fleet.emplace<Truck>(100, 6);
+    fleet.emplace<Sedan>(120, 4);
+    vehicle_specs(fleet);
+}
+
+// a million vehicles: the shared_ptr vector is shuffled (a fleet built over time is not allocated in scan order) so every
+// element is a jump to wherever its node is; the fleet walks two arrays of 16-byte objects
+void fleet_scan() {
+    cout << "fleet_scan" << endl;
+    using namespace chrono;
+    const int count = 1'000'000;
+    mt19937 rng {42};
+    vector<shared_ptr<Vehicle>> vehicles;
+    vehicles.reserve(count);
+    Fleet fleet;
+    fleet.reserve<Truck>(count / 3 + 1);
+    fleet.reserve<Sedan>(count);
+    for (int i = 0; i != count; i++) {
+        int speed = 80 + i % 90;
+        if (i % 3 == 0) {
+            vehicles.push_back(make_shared<Truck>(speed, 2 + i % 5));
+            fleet.emplace<Truck>(speed, 2 + i % 5);
+        } else {
+            vehicles.push_back(make_shared<Sedan>(speed, 4 + i % 2));
+            fleet.emplace<Sedan>(speed, 4 + i % 2);
+        }
+    }
+    shuffle(vehicles.begin(), vehicles.end(), rng);
+
+    auto time_it = [&](const string &name, auto scan) {
+        auto t1 = high_resolution_clock::now();
+        long result = scan();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, milli>(t2 - t1).count() << " ms (checksum " << result << ")" << endl;
+    };
+    time_it("vector<shared_ptr<Vehicle>>", [&] {
+        long seats = 0;
+        for (const shared_ptr<Vehicle> &v : vehicles) {
+            if (v->top_speed() > 120) {
+                seats += v->capacity();
+            }
+        }
+        return seats;
+    });
+    time_it("PolyCollection", [&] {
+        long seats = 0;
+        fleet.for_each([&](const auto &v) {
+            if (v.top_speed() > 120) {
+                seats += v.capacity();
+            }
+        });
+        return seats;
+    });
+    cout << "trucks: " << fleet.size<Truck>() << " - sedans: " << fleet.size<Sedan>() << " - total: " << fleet.size() << endl;
 }
 
 void using_lambda_as_initializer(int selector) {
@@ -193,8 +387,201 @@ void using_lambda_as_initializer(int selector) {
     cout << v[0] << endl;
 }
 
+// a 64 MB file of doubles worked on thru a mapping: written front to back, synced, then mapped again read-only and handed
+// to the same templates that take a TVector. Only the pages that are touched are ever read (the random probes below touch
+// 1000 pages out of 16000) and none of it is copied to the heap
+void mapped_vectors() {
+    cout << "mapped_vectors" << endl;
+    using namespace chrono;
+    const long len = 8'000'000;
+    string path = (filesystem::temp_directory_path() / "braintrain-mapped.bin").string();
+    {
+        auto values = MappedVector<double>::create(path, len);
+        values.advise(Access::sequential);
+        for (long i = 0; i != len; i++) {
+            values[i] = (i % 1000) * 0.001;
+        }
+        auto t1 = high_resolution_clock::now();
+        values.sync(); // blocks until the 64 MB are on the disk
+        auto t2 = high_resolution_clock::now();
+        cout << "wrote " << values.get_size() << " doubles, sync: " << duration<double, milli>(t2 - t1).count() << " ms" << endl;
+    }
+
+    auto values = MappedVector<double>::open(path, MappedVector<double>::Mode::read_only);
+    values.advise(Access::sequential);
+    double sum = func_template1(values, 0.0); // contiguous: summed pairwise straight out of the page cache
+    cout << "sum: " << sum << endl;
+    cout << "above 0.99: " << count_using_lambda(values, [](double d) { return d > 0.99; }) << endl;
+
+    values.advise(Access::random); // no read-ahead: each probe below faults in one page, not a whole window
+    double probes = 0;
+    for (long i = 0; i != 1000; i++) {
+        probes += values[(i * 7'919'003) % len];
+    }
+    cout << "random probes: " << probes << endl;
+    values.advise(Access::dont_need);
+    filesystem::remove(path); // the mapping keeps the data alive until it is unmapped
+}
+
+// views instead of copies: a slice, every other element (the left channel of interleaved stereo samples) and the vector
+// backwards all read the TVector in place. The benchmark sums overlapping windows of a big buffer, first the
+// pass_typed_vector way (copy each window into a new TVector) then thru slices
+void buffer_views() {
+    cout << "buffer_views" << endl;
+    TVector<int> v = {1, 2, 3, 4, 5, 6};
+    auto middle = slice(v, 1, 4);
+    auto odd = strided(v, 0, 3, 2);
+    auto backwards = reversed(v);
+    int middle_sum = func_template1(middle, 0); // contiguous: the pairwise sum
+    int odd_sum = func_template1(odd, 0); // not contiguous: the plain loop
+    cout << "slice sum: " << middle_sum << " - strided sum: " << odd_sum << endl;
+    cout << "> 3 backwards: " << count_using_lambda(backwards, [](int elem) { return elem > 3; }) << " - first: "
+         << backwards[0] << endl;
+    middle[0] = 20; // a view writes thru to the vector
+    cout << "v[1] = " << v[1] << endl;
+
+    using namespace chrono;
+    const int len = 1 << 20;
+    const int window = 4096;
+    TVector<double> samples(len);
+    for (int i = 0; i != len; i++) {
+        samples[i] = (i % 100) * 0.01;
+    }
+    auto time_it = [&](const string &name, auto window_sum) {
+        double s = 0;
+        auto t1 = high_resolution_clock::now();
+        for (int first = 0; first + window <= len; first += window / 2) { // half overlapping windows
+            s += window_sum(first);
+        }
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, milli>(t2 - t1).count() << " ms (checksum " << s << ")" << endl;
+    };
+    time_it("copied windows", [&](int first) {
+        TVector<double> w(window);
+        for (int i = 0; i != window; i++) {
+            w[i] = samples[first + i];
+        }
+        return summation::sum(w);
+    });
+    time_it("slice windows", [&](int first) { return summation::sum(slice(samples, first, window)); });
+    auto left = strided(samples, 0, len / 2, 2);
+    double left_sum = 0;
+    for (double d : left) {
+        left_sum += d;
+    }
+    cout << "left channel: " << left.get_size() << " samples, sum " << left_sum << endl;
+}
+
+// the capacity planner's questions over a million vehicles, asked of the objects (a virtual call and a dynamic_cast per
+// vehicle) and of a FleetTable (two or three columns, no objects)
+void capacity_planner() {
+    cout << "capacity_planner" << endl;
+    using namespace chrono;
+    const int count = 1'000'000;
+    Fleet fleet;
+    vector<shared_ptr<Vehicle>> vehicles;
+    vehicles.reserve(count);
+    for (int i = 0; i != count; i++) {
+        int speed = 80 + i * 7 % 90;
+        if (i % 3 == 0) {
+            vehicles.push_back(make_shared<Truck>(speed, 2 + i % 5));
+            fleet.emplace<Truck>(speed, 2 + i % 5);
+        } else {
+            vehicles.push_back(make_shared<Sedan>(speed, 4 + i % 2));
+            fleet.emplace<Sedan>(speed, 4 + i % 2);
+        }
+    }
+    FleetTable table;
+    table.add_all(fleet);
+
+    using C = FleetTable::Condition;
+    const vector<C> roomy {{FleetTable::Column::capacity, FleetTable::Cmp::greater, 4}};
+    const vector<C> fast_and_roomy {{FleetTable::Column::top_speed, FleetTable::Cmp::greater_equal, 120},
+                                    {FleetTable::Column::capacity, FleetTable::Cmp::greater, 4}};
+    auto time_it = [&](const string &name, auto query) {
+        auto t1 = high_resolution_clock::now();
+        FleetTable::PerKind result = query();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, micro>(t2 - t1).count() << " us (" << kind_name(VehicleKind::truck)
+             << " " << result[0] << ", " << kind_name(VehicleKind::sedan) << " " << result[1] << ")" << endl;
+    };
+    time_it("objects: capacity > 4 by kind", [&] {
+        FleetTable::PerKind counts {};
+        for (const shared_ptr<Vehicle> &v : vehicles) {
+            if (v->capacity() > 4) {
+                counts[dynamic_cast<const Truck *>(v.get()) ? 0 : 1]++;
+            }
+        }
+        return counts;
+    });
+    FleetTable::Isa best = FleetTable::active_isa();
+    for (FleetTable::Isa isa : {FleetTable::Isa::scalar, FleetTable::Isa::avx2}) {
+        if (FleetTable::use_isa(isa) != isa) {
+            break; // the cpu does not have it
+        }
+        string name = string("table ") + cpu::isa_name(isa);
+        time_it(name + ": capacity > 4 by kind", [&] { return table.count_by_kind(roomy); });
+        time_it(name + ": seats of speed >= 120 and capacity > 4 by kind", [&] {
+            return table.sum_by_kind(FleetTable::Column::capacity, fast_and_roomy);
+        });
+    }
+    FleetTable::use_isa(best);
+    cout << "vehicles: " << table.count() << " - first fast and roomy: row " << table.select(fast_and_roomy)[0] << endl;
+}
+
+// a filter that passes about half of random data is the worst case for a branch: the predictor guesses wrong about every
+// other element. The branchy loop (count_using_func_obj before pred::count_if) against the predicate algebra, with the
+// 16-byte and the 32-byte vectors
+void predicate_algebra() {
+    cout << "predicate_algebra" << endl;
+    using namespace chrono;
+    using namespace pred;
+    const int len = 10'000'000;
+    vector<int> values(len);
+    vector<float> readings(len);
+    mt19937 gen {42};
+    uniform_int_distribution<int> dist {0, 999};
+    for (int i = 0; i != len; i++) {
+        values[i] = dist(gen);
+        readings[i] = static_cast<float>(values[i]) * 0.01f - 5.0f;
+    }
+    auto time_it = [](const string &name, auto query) {
+        auto t1 = high_resolution_clock::now();
+        long result = query();
+        auto t2 = high_resolution_clock::now();
+        cout << name << ": " << duration<double, milli>(t2 - t1).count() << " ms (" << result << ")" << endl;
+    };
+    time_it("branchy > 500", [&] {
+        long count = 0;
+        for (int v : values) {
+            if (v > 500) {
+                count++;
+            }
+        }
+        return count;
+    });
+    time_it("lambda > 500", [&] { return pred::count_if(values, [](int v) { return v > 500; }); });
+    cpu::Isa was = pred::active_isa();
+    for (cpu::Isa level : {cpu::Isa::sse2, cpu::Isa::avx2}) {
+        if (pred::use_isa(level) != level) {
+            break; // the cpu does not have it
+        }
+        string isa = cpu::isa_name(level);
+        time_it(isa + " > 500", [&] { return pred::count_if(values, gt(500)); });
+        time_it(isa + " in [100, 200] or > 900", [&] { return pred::count_if(values, between(100, 200) || gt(900)); });
+        time_it(isa + " not == 7 and < 50", [&] { return pred::count_if(values, !eq(7) && lt(50)); });
+        time_it(isa + " floats in [-0.5, 0.5]", [&] { return pred::count_if(readings, between(-0.5, 0.5)); });
+    }
+    pred::use_isa(was);
+    long first = pred::find_if(values, gt(998));
+    cout << "first > 998: index " << first << " = " << values[first] << endl;
+}
+
 int main() {
     work_with_custom_typed_vector();
+    small_buffer_vector();
+    growable_vector();
+    pmr_vectors();
     deduce_template_args();
     func_template1_caller();
     count_using_func_obj_caller();
@@ -202,7 +589,14 @@ int main() {
     my_pair<string, int> p = my_string_pair("first", 3);
     cout << p.first << " - " << p.second << endl;
     vehicle_specs_caller();
+    fleet_scan();
+    capacity_planner();
     using_lambda_as_initializer(1);
+    static_vector();
+    scratch_list_benchmark();
+    mapped_vectors();
+    buffer_views();
+    predicate_algebra();
 //    generic_lambda(v);
 
     return 0;